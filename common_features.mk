@@ -94,6 +94,7 @@ ifeq ($(strip $(UNICODE_ENABLE)), yes)
 endif
 
 ifeq ($(strip $(UNICODE_COMMON)), yes)
+    OPT_DEFS += -DUNICODE_COMMON_ENABLE
     SRC += $(QUANTUM_DIR)/process_keycode/process_unicode_common.c
 endif
 
@@ -177,6 +178,18 @@ ifeq ($(strip $(USB_HID_ENABLE)), yes)
     include $(TMK_DIR)/protocol/usb_hid.mk
 endif
 
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    OPT_DEFS += -DSPLIT_KEYBOARD
+    CUSTOM_MATRIX = yes
+    SRC += $(QUANTUM_DIR)/split_common/split_util.c \
+           $(QUANTUM_DIR)/split_common/transport.c \
+           $(QUANTUM_DIR)/split_common/serial.c \
+           $(QUANTUM_DIR)/split_common/serial_usart.c \
+           $(QUANTUM_DIR)/split_common/i2c.c \
+           $(QUANTUM_DIR)/split_common/matrix.c
+    VPATH += $(QUANTUM_PATH)/split_common
+endif
+
 QUANTUM_SRC:= \
     $(QUANTUM_DIR)/quantum.c \
     $(QUANTUM_DIR)/keymap_common.c \
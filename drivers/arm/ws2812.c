@@ -0,0 +1,171 @@
+/*
+ * WS2812 driver for ChibiOS on STM32, sent by a timer and DMA
+ *
+ * The timer runs at 800 kHz and every bit of the frame is one compare
+ * value: a short pulse for a 0, a long one for a 1. The update event of
+ * the timer asks the DMA for the next value, so once a frame is encoded
+ * the CPU is not involved until the whole frame is out. The frame ends
+ * with compare values of 0, which hold the line low for the reset time,
+ * and the line stays low after the stream stops since the last value
+ * loaded is 0.
+ *
+ * There are two buffers. While one is on the wire the next frame is
+ * encoded into the other one and the DMA interrupt starts it when the
+ * first is done.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ws2812.h"
+
+#define BIT_PERIOD (WS2812_PWM_FREQUENCY / 800000)
+// 0.4 us high for a 0 and 0.8 us high for a 1
+#define DUTY_0 (BIT_PERIOD * 8 / 25)
+#define DUTY_1 (BIT_PERIOD * 16 / 25)
+
+#ifdef RGBW
+#  define BITS_PER_LED 32
+#else
+#  define BITS_PER_LED 24
+#endif
+// One slot more than the reset time, the last value is still being
+// output when the stream completes
+#define BUFFER_SIZE (RGBLED_NUM * BITS_PER_LED + WS2812_RESET_BITS + 1)
+
+#define DMA_MODE (STM32_DMA_CR_CHSEL(WS2812_DMA_CHANNEL) | STM32_DMA_CR_PL(3) | \
+                  STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_MINC | \
+                  STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD | \
+                  STM32_DMA_CR_TCIE | STM32_DMA_CR_TEIE)
+
+static uint16_t buffers[2][BUFFER_SIZE];
+static uint16_t lengths[2];
+// the buffer on the wire, or the one sent last
+static uint8_t active = 0;
+static volatile bool sending = false;
+static volatile bool queued = false;
+static bool initialized = false;
+
+static const PWMConfig pwm_config = {
+  .frequency = WS2812_PWM_FREQUENCY,
+  .period = BIT_PERIOD,
+  .callback = NULL,
+  // the other channels are left zero, PWM_OUTPUT_DISABLED
+  .channels = {
+    [WS2812_PWM_CHANNEL - 1] = {.mode = PWM_OUTPUT_ACTIVE_HIGH, .callback = NULL},
+  },
+  .cr2 = 0,
+  // every update event requests the next compare value
+  .dier = STM32_TIM_DIER_UDE,
+};
+
+__attribute__ ((weak))
+void ws2812_frame_sent(void) {
+}
+
+// Called with the kernel locked
+static void start_frame(uint8_t index) {
+  active = index;
+  sending = true;
+  dmaStreamSetMemory0(WS2812_DMA_STREAM, buffers[index]);
+  dmaStreamSetTransactionSize(WS2812_DMA_STREAM, lengths[index]);
+  dmaStreamSetMode(WS2812_DMA_STREAM, DMA_MODE);
+  dmaStreamEnable(WS2812_DMA_STREAM);
+}
+
+static void dma_complete(void *param, uint32_t flags) {
+  (void)param;
+  (void)flags;
+
+  osalSysLockFromISR();
+  dmaStreamDisable(WS2812_DMA_STREAM);
+  if (queued) {
+    queued = false;
+    start_frame(active ^ 1);
+  } else {
+    sending = false;
+  }
+  ws2812_frame_sent();
+  osalSysUnlockFromISR();
+}
+
+static void ws2812_init(void) {
+  palSetPadMode(WS2812_PORT, WS2812_PAD, WS2812_PAD_MODE);
+
+  dmaStreamAllocate(WS2812_DMA_STREAM, WS2812_DMA_IRQ_PRIORITY, dma_complete, NULL);
+  dmaStreamSetPeripheral(WS2812_DMA_STREAM, &(WS2812_PWM_DRIVER.tim->CCR[WS2812_PWM_CHANNEL - 1]));
+
+  pwmStart(&WS2812_PWM_DRIVER, &pwm_config);
+  // the line idles low until the first frame
+  pwmEnableChannel(&WS2812_PWM_DRIVER, WS2812_PWM_CHANNEL - 1, 0);
+  initialized = true;
+}
+
+static uint16_t *encode_byte(uint16_t *out, uint8_t byte) {
+  for (uint8_t mask = 0x80; mask; mask >>= 1) {
+    *out++ = (byte & mask) ? DUTY_1 : DUTY_0;
+  }
+  return out;
+}
+
+static void send(LED_TYPE *ledarray, uint16_t number_of_leds, bool white) {
+  if (!initialized) {
+    ws2812_init();
+  }
+  if (number_of_leds > RGBLED_NUM) {
+    number_of_leds = RGBLED_NUM;
+  }
+
+  // A frame waiting in the other buffer is replaced by this one, take it
+  // back before writing over it
+  osalSysLock();
+  queued = false;
+  uint8_t index = sending ? active ^ 1 : active;
+  osalSysUnlock();
+
+  uint16_t *out = buffers[index];
+  for (uint16_t i = 0; i < number_of_leds; i++) {
+    out = encode_byte(out, ledarray[i].g);
+    out = encode_byte(out, ledarray[i].r);
+    out = encode_byte(out, ledarray[i].b);
+#ifdef RGBW
+    out = encode_byte(out, white ? ledarray[i].w : 0);
+#else
+    (void)white;
+#endif
+  }
+  for (uint16_t i = 0; i < WS2812_RESET_BITS + 1; i++) {
+    *out++ = 0;
+  }
+  lengths[index] = out - buffers[index];
+
+  osalSysLock();
+  if (sending) {
+    queued = true;
+  } else {
+    start_frame(index);
+  }
+  osalSysUnlock();
+}
+
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t number_of_leds) {
+  send(ledarray, number_of_leds, false);
+}
+
+void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t number_of_leds) {
+  send(ledarray, number_of_leds, true);
+}
+
+bool ws2812_busy(void) {
+  return sending;
+}
@@ -0,0 +1,92 @@
+/*
+ * WS2812 driver for ChibiOS on STM32, sent by a timer and DMA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIGHT_WS2812_H_
+#define LIGHT_WS2812_H_
+
+// The keyboard settings first, RGBW changes LED_TYPE and the WS2812_*
+// defaults below only apply when the keyboard has not set them
+#include "config.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "hal.h"
+#include "rgblight_types.h"
+
+/* Timer, channel and DMA stream driving the data line. The defaults fit
+ * an STM32F303 with the strip on PA1: TIM2 channel 2 in alternate
+ * function 1, whose update request is served by DMA1 channel 2.
+ * STM32_PWM_USE_TIM2 has to be enabled in mcuconf.h.
+ */
+#ifndef WS2812_PWM_DRIVER
+#  define WS2812_PWM_DRIVER PWMD2
+#endif
+#ifndef WS2812_PWM_CHANNEL
+#  define WS2812_PWM_CHANNEL 2
+#endif
+#ifndef WS2812_DMA_STREAM
+#  define WS2812_DMA_STREAM STM32_DMA1_STREAM2
+#endif
+// Request line of the stream, only used by the DMAv2 controllers (F2/F4/F7)
+#ifndef WS2812_DMA_CHANNEL
+#  define WS2812_DMA_CHANNEL 3
+#endif
+#ifndef WS2812_DMA_IRQ_PRIORITY
+#  define WS2812_DMA_IRQ_PRIORITY 7
+#endif
+#ifndef WS2812_PORT
+#  define WS2812_PORT GPIOA
+#endif
+#ifndef WS2812_PAD
+#  define WS2812_PAD 1
+#endif
+#ifndef WS2812_PAD_MODE
+#  define WS2812_PAD_MODE PAL_MODE_ALTERNATE(1)
+#endif
+
+// Clock of the timer counter, a multiple of 800 kHz keeps the bits exact
+#ifndef WS2812_PWM_FREQUENCY
+#  define WS2812_PWM_FREQUENCY STM32_SYSCLK
+#endif
+// Low time after a frame before the strip latches it, in bit periods of
+// 1.25 us. 40 is the 50 us of the WS2812B datasheet, newer parts want 280 us.
+#ifndef WS2812_RESET_BITS
+#  define WS2812_RESET_BITS 40
+#endif
+
+/* User Interface
+ *
+ * Input:
+ *         ledarray:           An array of GRB data describing the LED colors
+ *         number_of_leds:     The number of LEDs to write
+ *
+ * The frame is encoded into whichever of the two DMA buffers is not on
+ * the wire and the functions return right away. If a frame is still
+ * being sent the new one starts as soon as it is done; a frame that was
+ * queued behind it and has not started yet is replaced.
+ */
+
+void ws2812_setleds     (LED_TYPE *ledarray, uint16_t number_of_leds);
+void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t number_of_leds);
+
+// true while a frame is on the wire or waiting for one
+bool ws2812_busy(void);
+
+// Called from the DMA interrupt when a frame, including its reset time,
+// has been sent. Keep it short, it runs with the kernel locked.
+void ws2812_frame_sent(void);
+
+#endif /* LIGHT_WS2812_H_ */
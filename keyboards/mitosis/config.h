@@ -73,15 +73,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SERIAL_UART_UBRR (F_CPU / (16UL * SERIAL_UART_BAUD) - 1)
 #define SERIAL_UART_TXD_READY (UCSR1A & _BV(UDRE1))
 #define SERIAL_UART_RXD_PRESENT (UCSR1A & _BV(RXC1))
+#define SERIAL_UART_RXD_VECT USART1_RX_vect
 #define SERIAL_UART_INIT() do { \
     	/* baud rate */ \
     	UBRR1L = SERIAL_UART_UBRR; \
     	/* baud rate */ \
     	UBRR1H = SERIAL_UART_UBRR >> 8; \
-    	/* enable TX and RX */ \
-    	UCSR1B = _BV(TXEN1) | _BV(RXEN1); \
+    	/* enable TX, RX and the RX complete interrupt */ \
+    	UCSR1B = _BV(TXEN1) | _BV(RXEN1) | _BV(RXCIE1); \
     	/* 8-bit data */ \
     	UCSR1C = _BV(UCSZ11) | _BV(UCSZ10); \
   	} while(0)
 
+//the s character requests the RF slave to send the matrix: 10 bytes
+//corresponding to 10 columns, and an end byte
+#define SERIAL_FRAME_REQUEST 's'
+#define SERIAL_FRAME_LENGTH 10
+#define SERIAL_FRAME_END 0xE0
+
 #endif
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 #include "matrix.h"
 #include "timer.h"
+#include "serial_frame.h"
 
 #if (MATRIX_COLS <= 8)
 #    define print_matrix_header()  print("\nr/c 01234567\n")
@@ -92,33 +93,13 @@ void matrix_init(void) {
 
 uint8_t matrix_scan(void)
 {
-    SERIAL_UART_INIT();
-
-    uint32_t timeout = 0;
-
-    //the s character requests the RF slave to send the matrix
-    SERIAL_UART_DATA = 's';
-
-    //trust the external keystates entirely, erase the last data
-    uint8_t uart_data[11] = {0};
-
-    //there are 10 bytes corresponding to 10 columns, and an end byte
-    for (uint8_t i = 0; i < 11; i++) {
-        //wait for the serial data, timeout if it's been too long
-        //this only happened in testing with a loose wire, but does no
-        //harm to leave it in here
-        while(!SERIAL_UART_RXD_PRESENT){
-            timeout++;
-            if (timeout > 10000){
-                break;
-            }
-        } 
-        uart_data[i] = SERIAL_UART_DATA;
-    }
+    //the receive interrupt collects the frames from the RF slave, only
+    //take the latest complete one here, never wait for it
+    uint8_t uart_data[SERIAL_FRAME_LENGTH];
 
-    //check for the end packet, the key state bytes use the LSBs, so 0xE0
-    //will only show up here if the correct bytes were recieved
-    if (uart_data[10] == 0xE0)
+    //the end byte has been checked already, the key state bytes use the
+    //LSBs, so 0xE0 will only show up there if the correct bytes were recieved
+    if (serial_frame_read(uart_data))
     {
         //shifting and transferring the keystates to the QMK matrix variable
         for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
@@ -1,7 +1,8 @@
 #include "mitosis.h"
+#include "serial_frame.h"
 
 void uart_init(void) {
-	SERIAL_UART_INIT();
+	serial_frame_init();
 }
 
 void led_init(void) {
@@ -30,8 +30,9 @@
 #define PREVENT_STUCK_MODIFIERS
 
 /* A larger buffer for the dynamic macros as this keymap is not taking
- * up that much memory.
+ * up that much memory. In bytes, the RAM of the 256 events it used to
+ * hold.
  */
-#define DYNAMIC_MACRO_SIZE 256
+#define DYNAMIC_MACRO_SIZE 1536
 
 #endif
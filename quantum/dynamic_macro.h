@@ -18,19 +18,51 @@
 #ifndef DYNAMIC_MACROS_H
 #define DYNAMIC_MACROS_H
 
+#include <string.h>
 #include "action_layer.h"
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+#include "eeprom.h"
+#endif
 
 #ifndef DYNAMIC_MACRO_SIZE
-/* May be overridden with a custom value. Be aware that the effective
- * macro length is half of this value: each keypress is recorded twice
- * because of the down-event and up-event. This is not a bug, it's the
- * intended behavior.
+/* May be overridden with a custom value. This is the size in bytes of
+ * the buffer shared by all the macros. Each key event takes a single
+ * byte (two on boards with more than 62 keys), and each keypress is
+ * recorded twice because of the down-event and up-event. This is not
+ * a bug, it's the intended behavior.
  *
- * Usually it should be fine to set the macro size to at least 256 but
- * there have been reports of it being too much in some users' cases,
- * so 128 is considered a safe default.
+ * It used to count recorded events of 6 bytes each, the default takes
+ * the same RAM as the old 128 events.
+ */
+#define DYNAMIC_MACRO_SIZE 768
+#endif
+
+#ifndef DYNAMIC_MACRO_SLOTS
+/* The number of macros sharing the buffer. Slots 1 and 2 use the
+ * DYN_REC_START1/2 and DYN_MACRO_PLAY1/2 keys, further ones are
+ * accessed with DYN_REC_START(n) and DYN_MACRO_PLAY(n).
+ */
+#define DYNAMIC_MACRO_SLOTS 2
+#endif
+
+#if DYNAMIC_MACRO_SLOTS < 2 || DYNAMIC_MACRO_SLOTS > 16
+#error "DYNAMIC_MACRO_SLOTS must be between 2 and 16"
+#endif
+
+#if DYNAMIC_MACRO_SIZE > 0xFFFF
+#error "DYNAMIC_MACRO_SIZE must fit in 16 bits"
+#endif
+
+#if MATRIX_ROWS * MATRIX_COLS > 256
+#error "Dynamic macros support at most 256 keys"
+#endif
+
+/* With DYNAMIC_MACRO_TIMING defined the pauses between the events are
+ * recorded too (in DYNAMIC_MACRO_TICK ms units, up to 255 ticks per
+ * pause) and reproduced during the playback.
  */
-#define DYNAMIC_MACRO_SIZE 128
+#ifndef DYNAMIC_MACRO_TICK
+#define DYNAMIC_MACRO_TICK 8
 #endif
 
 /* DYNAMIC_MACRO_RANGE must be set as the last element of user's
@@ -43,8 +75,67 @@ enum dynamic_macro_keycodes {
     DYN_REC_STOP,
     DYN_MACRO_PLAY1,
     DYN_MACRO_PLAY2,
+    /* Slots 3 and up, see DYN_REC_START(n) and DYN_MACRO_PLAY(n). */
+    DYN_REC_START_EXTRA,
+    DYN_MACRO_PLAY_EXTRA = DYN_REC_START_EXTRA + DYNAMIC_MACRO_SLOTS - 2,
+    DYNAMIC_MACRO_RANGE_END = DYN_MACRO_PLAY_EXTRA + DYNAMIC_MACRO_SLOTS - 2,
 };
 
+#define DYN_REC_START(n) \
+    ((n) == 1 ? DYN_REC_START1 : (n) == 2 ? DYN_REC_START2 : DYN_REC_START_EXTRA + (n) - 3)
+#define DYN_MACRO_PLAY(n) \
+    ((n) == 1 ? DYN_MACRO_PLAY1 : (n) == 2 ? DYN_MACRO_PLAY2 : DYN_MACRO_PLAY_EXTRA + (n) - 3)
+
+/* The events are stored as a byte stream:
+ *
+ *   PTKKKKKK              a key event: P - pressed, T - tapped,
+ *                         K - the key index (row * MATRIX_COLS + col)
+ *   PT111111 KKKKKKKK     a key event with the key index >= 62
+ *   00111110 DDDDDDDD     a pause of D * DYNAMIC_MACRO_TICK ms
+ */
+#define DYNAMIC_MACRO_PRESSED  0x80
+#define DYNAMIC_MACRO_TAPPED   0x40
+#define DYNAMIC_MACRO_KEY_MASK 0x3F
+#define DYNAMIC_MACRO_PAUSE    0x3E
+#define DYNAMIC_MACRO_LONG_KEY 0x3F
+
+typedef struct {
+    uint16_t start;
+    uint16_t length;
+} dynamic_macro_slot_t;
+
+/* All the macros live in a single buffer, one after another, in no
+ * particular order. The macro being recorded is always the last one,
+ * so it can grow into the free space.
+ *
+ *  buffer                          used
+ *  v                                v
+ * +---------------------------------------------------------------+
+ * | MACRO3 | MACRO1 |  MACRO2 >>>>>>   free space                  |
+ * +---------------------------------------------------------------+
+ *
+ * Re-recording a macro first removes it and moves the ones after it
+ * down. There are no arbitrary limits for the macros' length in
+ * relation to each other.
+ */
+static uint8_t dynamic_macro_buffer[DYNAMIC_MACRO_SIZE];
+static dynamic_macro_slot_t dynamic_macro_slots[DYNAMIC_MACRO_SLOTS];
+static uint16_t dynamic_macro_used = 0;
+
+/* 0 - no macro is being recorded right now
+ * n - macro n is being recorded */
+static uint8_t dynamic_macro_recording = 0;
+
+/* The length of the macro being recorded up to its last key-up
+ * event, used to trim the trailing key-down events. */
+static uint16_t dynamic_macro_keep = 0;
+
+#ifdef DYNAMIC_MACRO_TIMING
+static uint16_t dynamic_macro_last_time = 0;
+#endif
+
+static bool dynamic_macro_playing = false;
+
 /* Blink the LEDs to notify the user about some event. */
 void dynamic_macro_led_blink(void)
 {
@@ -55,55 +146,154 @@ void dynamic_macro_led_blink(void)
 #endif
 }
 
-/* Convenience macros used for retrieving the debug info. All of them
- * need a `direction` variable accessible at the call site.
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+/* The EEPROM layout: the magic word, the used length, the slots and
+ * then the used part of the buffer. It needs
+ * 4 + 4 * DYNAMIC_MACRO_SLOTS + DYNAMIC_MACRO_SIZE bytes.
  */
-#define DYNAMIC_MACRO_CURRENT_SLOT() (direction > 0 ? 1 : 2)
-#define DYNAMIC_MACRO_CURRENT_LENGTH(BEGIN, POINTER) \
-    ((int)(direction * ((POINTER) - (BEGIN))))
-#define DYNAMIC_MACRO_CURRENT_CAPACITY(BEGIN, END2) \
-    ((int)(direction * ((END2) - (BEGIN)) + 1))
+#define DYNAMIC_MACRO_EEPROM_MAGIC (uint16_t)(0xD700 + DYNAMIC_MACRO_SLOTS)
+#define DYNAMIC_MACRO_EEPROM_USED  (DYNAMIC_MACRO_EEPROM_ADDR + 2)
+#define DYNAMIC_MACRO_EEPROM_SLOTS (DYNAMIC_MACRO_EEPROM_ADDR + 4)
+#define DYNAMIC_MACRO_EEPROM_DATA  (DYNAMIC_MACRO_EEPROM_SLOTS + sizeof(dynamic_macro_slots))
+
+/* Store the macros. The header goes last so that the data it
+ * describes is already in place. eeprom_update_block() only writes the
+ * bytes that differ, which spares the cells of unchanged macros. */
+void dynamic_macro_save(void)
+{
+    uint16_t magic = DYNAMIC_MACRO_EEPROM_MAGIC;
+
+    eeprom_update_block(dynamic_macro_buffer, (void *)DYNAMIC_MACRO_EEPROM_DATA, dynamic_macro_used);
+    eeprom_update_block(dynamic_macro_slots, (void *)DYNAMIC_MACRO_EEPROM_SLOTS, sizeof(dynamic_macro_slots));
+    eeprom_update_block(&dynamic_macro_used, (void *)DYNAMIC_MACRO_EEPROM_USED, sizeof(dynamic_macro_used));
+    eeprom_update_block(&magic, (void *)DYNAMIC_MACRO_EEPROM_ADDR, sizeof(magic));
+}
+
+/* Restore the macros saved by dynamic_macro_save(), if there are any
+ * and they look sane. */
+void dynamic_macro_load(void)
+{
+    if (eeprom_read_word((const uint16_t *)DYNAMIC_MACRO_EEPROM_ADDR) != DYNAMIC_MACRO_EEPROM_MAGIC) {
+        return;
+    }
+
+    uint16_t used = eeprom_read_word((const uint16_t *)DYNAMIC_MACRO_EEPROM_USED);
+    if (used > DYNAMIC_MACRO_SIZE) {
+        return;
+    }
+
+    dynamic_macro_slot_t slots[DYNAMIC_MACRO_SLOTS];
+    eeprom_read_block(slots, (const void *)DYNAMIC_MACRO_EEPROM_SLOTS, sizeof(slots));
+    for (uint8_t i = 0; i < DYNAMIC_MACRO_SLOTS; i++) {
+        if (slots[i].start > used || slots[i].length > used - slots[i].start) {
+            return;
+        }
+    }
+
+    eeprom_read_block(dynamic_macro_buffer, (const void *)DYNAMIC_MACRO_EEPROM_DATA, used);
+    memcpy(dynamic_macro_slots, slots, sizeof(slots));
+    dynamic_macro_used = used;
+    dprintf("dynamic macro: loaded %d bytes\n", used);
+}
+#endif
+
+/* Remove a macro from the buffer, moving the ones stored after it
+ * down to close the gap. */
+void dynamic_macro_erase(uint8_t slot)
+{
+    dynamic_macro_slot_t *macro = &dynamic_macro_slots[slot];
+    uint16_t end = macro->start + macro->length;
+
+    if (macro->length == 0) {
+        return;
+    }
+
+    memmove(dynamic_macro_buffer + macro->start,
+            dynamic_macro_buffer + end,
+            dynamic_macro_used - end);
+
+    for (uint8_t i = 0; i < DYNAMIC_MACRO_SLOTS; i++) {
+        if (dynamic_macro_slots[i].length != 0 && dynamic_macro_slots[i].start >= end) {
+            dynamic_macro_slots[i].start -= macro->length;
+        }
+    }
+
+    dynamic_macro_used -= macro->length;
+    macro->length = 0;
+}
 
 /**
  * Start recording of the dynamic macro.
  *
- * @param[out] macro_pointer The new macro buffer iterator.
- * @param[in]  macro_buffer  The macro buffer used to initialize macro_pointer.
+ * @param[in] slot The macro slot, counting from 0.
  */
-void dynamic_macro_record_start(
-    keyrecord_t **macro_pointer, keyrecord_t *macro_buffer)
+void dynamic_macro_record_start(uint8_t slot)
 {
-    dprintln("dynamic macro recording: started");
+    dprintf("dynamic macro: slot %d recording started\n", slot + 1);
 
     dynamic_macro_led_blink();
 
     clear_keyboard();
     layer_clear();
-    *macro_pointer = macro_buffer;
+
+    /* The old contents are dropped right away: the new macro is
+     * recorded at the end of the buffer. */
+    dynamic_macro_erase(slot);
+    dynamic_macro_slots[slot].start = dynamic_macro_used;
+    dynamic_macro_keep = 0;
+    dynamic_macro_recording = slot + 1;
 }
 
 /**
  * Play the dynamic macro.
  *
- * @param macro_buffer[in] The beginning of the macro buffer being played.
- * @param macro_end[in]    The element after the last macro buffer element.
- * @param direction[in]    Either +1 or -1, which way to iterate the buffer.
+ * @param[in] slot The macro slot, counting from 0.
  */
-void dynamic_macro_play(
-    keyrecord_t *macro_buffer, keyrecord_t *macro_end, int8_t direction)
+void dynamic_macro_play(uint8_t slot)
 {
-    dprintf("dynamic macro: slot %d playback\n", DYNAMIC_MACRO_CURRENT_SLOT());
+    const uint8_t *p = dynamic_macro_buffer + dynamic_macro_slots[slot].start;
+    const uint8_t *end = p + dynamic_macro_slots[slot].length;
+
+    dprintf("dynamic macro: slot %d playback\n", slot + 1);
 
     uint32_t saved_layer_state = layer_state;
 
     clear_keyboard();
     layer_clear();
 
-    while (macro_buffer != macro_end) {
-        process_record(macro_buffer);
-        macro_buffer += direction;
+    dynamic_macro_playing = true;
+
+    while (p != end) {
+        uint8_t data = *p++;
+        uint8_t index = data & DYNAMIC_MACRO_KEY_MASK;
+
+        if (data == DYNAMIC_MACRO_PAUSE) {
+            uint8_t ticks = *p++;
+            while (ticks--) {
+                wait_ms(DYNAMIC_MACRO_TICK);
+            }
+            continue;
+        }
+        if (index == DYNAMIC_MACRO_LONG_KEY) {
+            index = *p++;
+        }
+
+        keyrecord_t record = {
+            .event = {
+                .key = { .col = index % MATRIX_COLS, .row = index / MATRIX_COLS },
+                .pressed = data & DYNAMIC_MACRO_PRESSED,
+                /* Zero would make it a non-event. */
+                .time = timer_read() | 1,
+            },
+        };
+#ifndef NO_ACTION_TAPPING
+        record.tap.count = (data & DYNAMIC_MACRO_TAPPED) ? 1 : 0;
+#endif
+        process_record(&record);
     }
 
+    dynamic_macro_playing = false;
+
     clear_keyboard();
 
     layer_state = saved_layer_state;
@@ -112,69 +302,129 @@ void dynamic_macro_play(
 /**
  * Record a single key in a dynamic macro.
  *
- * @param macro_buffer[in] The start of the used macro buffer.
- * @param macro_pointer[in,out] The current buffer position.
- * @param macro2_end[in] The end of the other macro.
- * @param direction[in]  Either +1 or -1, which way to iterate the buffer.
- * @param record[in]     The current keypress.
+ * @param[in] record The current keypress.
  */
-void dynamic_macro_record_key(
-    keyrecord_t *macro_buffer,
-    keyrecord_t **macro_pointer,
-    keyrecord_t *macro2_end,
-    int8_t direction,
-    keyrecord_t *record)
+void dynamic_macro_record_key(keyrecord_t *record)
 {
+    dynamic_macro_slot_t *macro = &dynamic_macro_slots[dynamic_macro_recording - 1];
+    uint8_t data[4];
+    uint8_t length = 0;
+
     /* If we've just started recording, ignore all the key releases. */
-    if (!record->event.pressed && *macro_pointer == macro_buffer) {
+    if (!record->event.pressed && macro->length == 0) {
         dprintln("dynamic macro: ignoring a leading key-up event");
         return;
     }
 
-    /* The other end of the other macro is the last buffer element it
-     * is safe to use before overwriting the other macro.
-     */
-    if (*macro_pointer - direction != macro2_end) {
-        **macro_pointer = *record;
-        *macro_pointer += direction;
+    if (record->event.key.row >= MATRIX_ROWS || record->event.key.col >= MATRIX_COLS) {
+        dprintln("dynamic macro: ignoring an event outside of the matrix");
+        return;
+    }
+
+#ifdef DYNAMIC_MACRO_TIMING
+    if (macro->length != 0) {
+        uint16_t ticks = TIMER_DIFF_16(record->event.time, dynamic_macro_last_time) / DYNAMIC_MACRO_TICK;
+        if (ticks != 0) {
+            data[length++] = DYNAMIC_MACRO_PAUSE;
+            data[length++] = ticks > 0xFF ? 0xFF : ticks;
+        }
+    }
+#endif
+
+    uint8_t index = record->event.key.row * MATRIX_COLS + record->event.key.col;
+    uint8_t flags = record->event.pressed ? DYNAMIC_MACRO_PRESSED : 0;
+#ifndef NO_ACTION_TAPPING
+    if (record->tap.count) {
+        flags |= DYNAMIC_MACRO_TAPPED;
+    }
+#endif
+    if (index < DYNAMIC_MACRO_PAUSE) {
+        data[length++] = flags | index;
+    } else {
+        data[length++] = flags | DYNAMIC_MACRO_LONG_KEY;
+        data[length++] = index;
+    }
+
+    if (length <= DYNAMIC_MACRO_SIZE - dynamic_macro_used) {
+        memcpy(dynamic_macro_buffer + dynamic_macro_used, data, length);
+        dynamic_macro_used += length;
+        macro->length += length;
+        if (!record->event.pressed) {
+            dynamic_macro_keep = macro->length;
+        }
+#ifdef DYNAMIC_MACRO_TIMING
+        dynamic_macro_last_time = record->event.time;
+#endif
     } else {
         dynamic_macro_led_blink();
     }
 
     dprintf(
         "dynamic macro: slot %d length: %d/%d\n",
-        DYNAMIC_MACRO_CURRENT_SLOT(),
-        DYNAMIC_MACRO_CURRENT_LENGTH(macro_buffer, *macro_pointer),
-        DYNAMIC_MACRO_CURRENT_CAPACITY(macro_buffer, macro2_end));
+        dynamic_macro_recording,
+        macro->length,
+        DYNAMIC_MACRO_SIZE - dynamic_macro_used + macro->length);
 }
 
 /**
- * End recording of the dynamic macro. Essentially just update the
- * pointer to the end of the macro.
+ * End recording of the dynamic macro.
  */
-void dynamic_macro_record_end(
-    keyrecord_t *macro_buffer,
-    keyrecord_t *macro_pointer,
-    int8_t direction,
-    keyrecord_t **macro_end)
+void dynamic_macro_record_end(void)
 {
+    dynamic_macro_slot_t *macro = &dynamic_macro_slots[dynamic_macro_recording - 1];
+
     dynamic_macro_led_blink();
 
     /* Do not save the keys being held when stopping the recording,
      * i.e. the keys used to access the layer DYN_REC_STOP is on.
      */
-    while (macro_pointer != macro_buffer &&
-           (macro_pointer - direction)->event.pressed) {
-        dprintln("dynamic macro: trimming a trailing key-down event");
-        macro_pointer -= direction;
+    if (macro->length != dynamic_macro_keep) {
+        dprintln("dynamic macro: trimming the trailing key-down events");
+        dynamic_macro_used -= macro->length - dynamic_macro_keep;
+        macro->length = dynamic_macro_keep;
     }
 
     dprintf(
         "dynamic macro: slot %d saved, length: %d\n",
-        DYNAMIC_MACRO_CURRENT_SLOT(),
-        DYNAMIC_MACRO_CURRENT_LENGTH(macro_buffer, macro_pointer));
+        dynamic_macro_recording,
+        macro->length);
+
+    dynamic_macro_recording = 0;
 
-    *macro_end = macro_pointer;
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+    dynamic_macro_save();
+#endif
+}
+
+/* Returns the slot (counting from 0) a DYN_REC_START* key refers to,
+ * or -1 for any other key. */
+int8_t dynamic_macro_record_slot(uint16_t keycode)
+{
+    if (keycode == DYN_REC_START1) {
+        return 0;
+    }
+    if (keycode == DYN_REC_START2) {
+        return 1;
+    }
+    if (keycode >= DYN_REC_START_EXTRA && keycode < DYN_MACRO_PLAY_EXTRA) {
+        return keycode - DYN_REC_START_EXTRA + 2;
+    }
+    return -1;
+}
+
+/* Like dynamic_macro_record_slot() but for the DYN_MACRO_PLAY* keys. */
+int8_t dynamic_macro_play_slot(uint16_t keycode)
+{
+    if (keycode == DYN_MACRO_PLAY1) {
+        return 0;
+    }
+    if (keycode == DYN_MACRO_PLAY2) {
+        return 1;
+    }
+    if (keycode >= DYN_MACRO_PLAY_EXTRA && keycode < DYNAMIC_MACRO_RANGE_END) {
+        return keycode - DYN_MACRO_PLAY_EXTRA + 2;
+    }
+    return -1;
 }
 
 /* Handle the key events related to the dynamic macros. Should be
@@ -189,115 +439,56 @@ void dynamic_macro_record_end(
  */
 bool process_record_dynamic_macro(uint16_t keycode, keyrecord_t *record)
 {
-    /* Both macros use the same buffer but read/write on different
-     * ends of it.
-     *
-     * Macro1 is written left-to-right starting from the beginning of
-     * the buffer.
-     *
-     * Macro2 is written right-to-left starting from the end of the
-     * buffer.
-     *
-     * &macro_buffer   macro_end
-     *  v                   v
-     * +------------------------------------------------------------+
-     * |>>>>>> MACRO1 >>>>>>      <<<<<<<<<<<<< MACRO2 <<<<<<<<<<<<<|
-     * +------------------------------------------------------------+
-     *                           ^                                 ^
-     *                         r_macro_end                  r_macro_buffer
-     *
-     * During the recording when one macro encounters the end of the
-     * other macro, the recording is stopped. Apart from this, there
-     * are no arbitrary limits for the macros' length in relation to
-     * each other: for example one can either have two medium sized
-     * macros or one long macro and one short macro. Or even one empty
-     * and one using the whole buffer.
-     */
-    static keyrecord_t macro_buffer[DYNAMIC_MACRO_SIZE];
-
-    /* Pointer to the first buffer element after the first macro.
-     * Initially points to the very beginning of the buffer since the
-     * macro is empty. */
-    static keyrecord_t *macro_end = macro_buffer;
-
-    /* The other end of the macro buffer. Serves as the beginning of
-     * the second macro. */
-    static keyrecord_t *const r_macro_buffer = macro_buffer + DYNAMIC_MACRO_SIZE - 1;
-
-    /* Like macro_end but for the second macro. */
-    static keyrecord_t *r_macro_end = r_macro_buffer;
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+    static bool loaded = false;
 
-    /* A persistent pointer to the current macro position (iterator)
-     * used during the recording. */
-    static keyrecord_t *macro_pointer = NULL;
+    if (!loaded) {
+        dynamic_macro_load();
+        loaded = true;
+    }
+#endif
 
-    /* 0   - no macro is being recorded right now
-     * 1,2 - either macro 1 or 2 is being recorded */
-    static uint8_t macro_id = 0;
+    /* The keys recorded in a macro cannot start, stop or play the
+     * macros, which would change the buffer being played. */
+    if (dynamic_macro_playing) {
+        return keycode < DYN_REC_START1 || keycode >= DYNAMIC_MACRO_RANGE_END;
+    }
 
-    if (macro_id == 0) {
+    if (dynamic_macro_recording == 0) {
         /* No macro recording in progress. */
         if (!record->event.pressed) {
-            switch (keycode) {
-            case DYN_REC_START1:
-                dynamic_macro_record_start(&macro_pointer, macro_buffer);
-                macro_id = 1;
+            int8_t slot = dynamic_macro_record_slot(keycode);
+            if (slot >= 0) {
+                dynamic_macro_record_start(slot);
                 return false;
-            case DYN_REC_START2:
-                dynamic_macro_record_start(&macro_pointer, r_macro_buffer);
-                macro_id = 2;
-                return false;
-            case DYN_MACRO_PLAY1:
-                dynamic_macro_play(macro_buffer, macro_end, +1);
-                return false;
-            case DYN_MACRO_PLAY2:
-                dynamic_macro_play(r_macro_buffer, r_macro_end, -1);
+            }
+            slot = dynamic_macro_play_slot(keycode);
+            if (slot >= 0) {
+                dynamic_macro_play(slot);
                 return false;
             }
         }
     } else {
         /* A macro is being recorded right now. */
-        switch (keycode) {
-        case DYN_REC_STOP:
+        if (keycode == DYN_REC_STOP) {
             /* Stop the macro recording. */
             if (record->event.pressed) { /* Ignore the initial release
                                           * just after the recoding
                                           * starts. */
-                switch (macro_id) {
-                case 1:
-                    dynamic_macro_record_end(macro_buffer, macro_pointer, +1, &macro_end);
-                    break;
-                case 2:
-                    dynamic_macro_record_end(r_macro_buffer, macro_pointer, -1, &r_macro_end);
-                    break;
-                }
-                macro_id = 0;
+                dynamic_macro_record_end();
             }
             return false;
-        case DYN_MACRO_PLAY1:
-        case DYN_MACRO_PLAY2:
+        }
+        if (dynamic_macro_play_slot(keycode) >= 0) {
             dprintln("dynamic macro: ignoring macro play key while recording");
             return false;
-        default:
-            /* Store the key in the macro buffer and process it normally. */
-            switch (macro_id) {
-            case 1:
-                dynamic_macro_record_key(macro_buffer, &macro_pointer, r_macro_end, +1, record);
-                break;
-            case 2:
-                dynamic_macro_record_key(r_macro_buffer, &macro_pointer, macro_end, -1, record);
-                break;
-            }
-            return true;
-            break;
         }
+        /* Store the key in the macro buffer and process it normally. */
+        dynamic_macro_record_key(record);
+        return true;
     }
 
     return true;
 }
 
-#undef DYNAMIC_MACRO_CURRENT_SLOT
-#undef DYNAMIC_MACRO_CURRENT_LENGTH
-#undef DYNAMIC_MACRO_CURRENT_CAPACITY
-
 #endif
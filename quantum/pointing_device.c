@@ -25,30 +25,90 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 static report_mouse_t mouseReport = {};
 
+/* Motion not sent to the host yet. The wheels are counted in
+ * 1/POINTING_DEVICE_WHEEL_RESOLUTION steps. */
+static int16_t pendingX = 0;
+static int16_t pendingY = 0;
+static int16_t pendingV = 0;
+static int16_t pendingH = 0;
+static uint8_t sentButtons = 0;
+static uint16_t lastSend = 0;
+
+static int16_t add_saturated(int16_t a, int16_t b){
+    int32_t sum = (int32_t)a + b;
+    return sum > INT16_MAX ? INT16_MAX : (sum < INT16_MIN ? INT16_MIN : sum);
+}
+
+/* Take as many whole units as fit in a report, the rest stays pending */
+static int8_t take_units(int16_t *pending, int16_t unit){
+    int16_t units = *pending / unit;
+    if (units > 127) units = 127;
+    if (units < -127) units = -127;
+    *pending -= units * unit;
+    return units;
+}
+
 __attribute__ ((weak))
 void pointing_device_init(void){
     //initialize device, if that needs to be done.
 }
 
+void pointing_device_add_motion(int16_t x, int16_t y, int16_t v, int16_t h){
+    pendingX = add_saturated(pendingX, x);
+    pendingY = add_saturated(pendingY, y);
+    pendingV = add_saturated(pendingV, v);
+    pendingH = add_saturated(pendingH, h);
+}
+
+void pointing_device_set_buttons(uint8_t buttons){
+    mouseReport.buttons = buttons;
+}
+
 __attribute__ ((weak))
 void pointing_device_send(void){
     //If you need to do other things, like debugging, this is the place to do it.
-    host_mouse_send(&mouseReport);
-	//send it and 0 it out except for buttons, so those stay until they are explicity over-ridden using update_pointing_device
-	mouseReport.x = 0;
-	mouseReport.y = 0;
-	mouseReport.v = 0;
-	mouseReport.h = 0;
+    //Motion put straight into the report is added to the pending motion, and 0 it out except for buttons,
+    //so those stay until they are explicity over-ridden using update_pointing_device
+    pointing_device_add_motion(mouseReport.x, mouseReport.y,
+                               mouseReport.v * POINTING_DEVICE_WHEEL_RESOLUTION,
+                               mouseReport.h * POINTING_DEVICE_WHEEL_RESOLUTION);
+    mouseReport.x = 0;
+    mouseReport.y = 0;
+    mouseReport.v = 0;
+    mouseReport.h = 0;
+
+    //Button changes go out right away, motion is coalesced into one report per host poll
+    if (mouseReport.buttons == sentButtons) {
+        if (!pendingX && !pendingY &&
+            pendingV / POINTING_DEVICE_WHEEL_RESOLUTION == 0 &&
+            pendingH / POINTING_DEVICE_WHEEL_RESOLUTION == 0) {
+            return;
+        }
+        if (timer_elapsed(lastSend) < POINTING_DEVICE_REPORT_INTERVAL) {
+            return;
+        }
+    }
+
+    report_mouse_t report = { .buttons = mouseReport.buttons };
+    report.x = take_units(&pendingX, 1);
+    report.y = take_units(&pendingY, 1);
+    report.v = take_units(&pendingV, POINTING_DEVICE_WHEEL_RESOLUTION);
+    report.h = take_units(&pendingH, POINTING_DEVICE_WHEEL_RESOLUTION);
+    host_mouse_send(&report);
+    sentButtons = report.buttons;
+    lastSend = timer_read();
 }
 
 __attribute__ ((weak))
 void pointing_device_task(void){
     //gather info and put it in:
+    //pointing_device_add_motion(x, y, v, h) with 16 bit deltas, any amount of them between reports
+    //pointing_device_set_buttons(buttons) = 0x1F (decimal 31, binary 00011111) max (bitmask for mouse buttons 1-5, 1 is rightmost, 5 is leftmost) 0x00 min
+    //or, as before, into the report itself:
     //mouseReport.x = 127 max -127 min
     //mouseReport.y = 127 max -127 min
     //mouseReport.v = 127 max -127 min (scroll vertical)
     //mouseReport.h = 127 max -127 min (scroll horizontal)
-    //mouseReport.buttons = 0x1F (decimal 31, binary 00011111) max (bitmask for mouse buttons 1-5, 1 is rightmost, 5 is leftmost) 0x00 min
     //send the report
     pointing_device_send();
 }
@@ -59,4 +119,4 @@ report_mouse_t pointing_device_get_report(void){
 
 void pointing_device_set_report(report_mouse_t newMouseReport){
 	mouseReport = newMouseReport;
-}
\ No newline at end of file
+}
@@ -22,10 +22,34 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "host.h"
 #include "report.h"
 
+/* Milliseconds between motion reports, best matched to the USB polling interval */
+#ifndef POINTING_DEVICE_REPORT_INTERVAL
+#   if defined(__AVR__)
+#       define POINTING_DEVICE_REPORT_INTERVAL 10
+#   else
+#       define POINTING_DEVICE_REPORT_INTERVAL 1
+#   endif
+#endif
+
+/* Wheel motion given to pointing_device_add_motion() is in 1/POINTING_DEVICE_WHEEL_RESOLUTION steps */
+#ifndef POINTING_DEVICE_WHEEL_RESOLUTION
+#define POINTING_DEVICE_WHEEL_RESOLUTION 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void pointing_device_init(void);
 void pointing_device_task(void);
 void pointing_device_send(void);
 report_mouse_t pointing_device_get_report(void);
 void pointing_device_set_report(report_mouse_t newMouseReport);
+void pointing_device_add_motion(int16_t x, int16_t y, int16_t v, int16_t h);
+void pointing_device_set_buttons(uint8_t buttons);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
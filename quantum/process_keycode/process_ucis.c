@@ -15,6 +15,8 @@
  */
 
 #include "process_ucis.h"
+#include <string.h>
+#include "debug.h"
 
 qk_ucis_state_t qk_ucis_state;
 
@@ -32,22 +34,121 @@ void qk_ucis_start_user(void) {
   unicode_input_finish();
 }
 
-static bool is_uni_seq(char *seq) {
+/* ucis_symbol_table is searched with a binary search when its names are
+ * in strcmp() order, which is checked once; an unsorted table still works
+ * but falls back to a linear scan.
+ */
+enum {
+  UCIS_TABLE_UNCHECKED,
+  UCIS_TABLE_SORTED,
+  UCIS_TABLE_UNSORTED,
+};
+
+static uint8_t ucis_table_state = UCIS_TABLE_UNCHECKED;
+static uint16_t ucis_table_size;
+
+static void ucis_check_table(void) {
+  uint16_t i;
+
+  if (ucis_table_state != UCIS_TABLE_UNCHECKED)
+    return;
+
+  ucis_table_state = UCIS_TABLE_SORTED;
+  for (i = 0; ucis_symbol_table[i].symbol; i++) {
+    if (i > 0 && strcmp(ucis_symbol_table[i - 1].symbol, ucis_symbol_table[i].symbol) >= 0)
+      ucis_table_state = UCIS_TABLE_UNSORTED;
+  }
+  ucis_table_size = i;
+
+  if (ucis_table_state == UCIS_TABLE_UNSORTED)
+    dprint("UCIS: ucis_symbol_table is not sorted, using linear lookup\n");
+}
+
+/* Turn the typed keycodes into the symbol name, up to count keys */
+static bool ucis_typed_name(char *name, uint8_t count) {
   uint8_t i;
 
-  for (i = 0; seq[i]; i++) {
-    uint16_t code;
-    if (('1' <= seq[i]) && (seq[i] <= '0'))
-      code = seq[i] - '1' + KC_1;
+  for (i = 0; i < count; i++) {
+    uint16_t code = qk_ucis_state.codes[i];
+    if (KC_A <= code && code <= KC_Z)
+      name[i] = code - KC_A + 'a';
+    else if (KC_1 <= code && code <= KC_9)
+      name[i] = code - KC_1 + '1';
+    else if (code == KC_0)
+      name[i] = '0';
     else
-      code = seq[i] - 'a' + KC_A;
-
-    if (i > qk_ucis_state.count || qk_ucis_state.codes[i] != code)
       return false;
   }
+  name[i] = 0;
+  return true;
+}
 
-  return (qk_ucis_state.codes[i] == KC_ENT ||
-          qk_ucis_state.codes[i] == KC_SPC);
+/* Index of the first symbol not ordering before name, within a sorted table */
+static uint16_t ucis_lower_bound(const char *name) {
+  uint16_t lo = 0, hi = ucis_table_size;
+
+  while (lo < hi) {
+    uint16_t mid = lo + (hi - lo) / 2;
+    if (strcmp(ucis_symbol_table[mid].symbol, name) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static bool ucis_has_prefix(const char *symbol, const char *prefix, uint8_t len) {
+  return strncmp(symbol, prefix, len) == 0;
+}
+
+static const qk_ucis_symbol_t *ucis_lookup(const char *name) {
+  uint16_t i;
+
+  ucis_check_table();
+  if (ucis_table_state == UCIS_TABLE_SORTED) {
+    i = ucis_lower_bound(name);
+    if (i < ucis_table_size && strcmp(ucis_symbol_table[i].symbol, name) == 0)
+      return &ucis_symbol_table[i];
+    return NULL;
+  }
+
+  for (i = 0; i < ucis_table_size; i++) {
+    if (strcmp(ucis_symbol_table[i].symbol, name) == 0)
+      return &ucis_symbol_table[i];
+  }
+  return NULL;
+}
+
+uint16_t qk_ucis_completions(const qk_ucis_symbol_t **first) {
+  char prefix[UCIS_MAX_SYMBOL_LENGTH + 1];
+  uint16_t i, count = 0;
+
+  *first = NULL;
+  if (!qk_ucis_state.in_progress || !ucis_typed_name(prefix, qk_ucis_state.count))
+    return 0;
+
+  ucis_check_table();
+  if (ucis_table_state == UCIS_TABLE_SORTED) {
+    i = ucis_lower_bound(prefix);
+    if (i < ucis_table_size)
+      *first = &ucis_symbol_table[i];
+    while (i < ucis_table_size && ucis_has_prefix(ucis_symbol_table[i].symbol, prefix, qk_ucis_state.count)) {
+      count++;
+      i++;
+    }
+    if (count == 0)
+      *first = NULL;
+    return count;
+  }
+
+  for (i = 0; i < ucis_table_size; i++) {
+    if (ucis_has_prefix(ucis_symbol_table[i].symbol, prefix, qk_ucis_state.count)) {
+      if (count == 0)
+        *first = &ucis_symbol_table[i];
+      count++;
+    }
+  }
+  return count;
 }
 
 __attribute__((weak))
@@ -116,8 +217,6 @@ bool process_ucis (uint16_t keycode, keyrecord_t *record) {
   }
 
   if (keycode == KC_ENT || keycode == KC_SPC || keycode == KC_ESC) {
-    bool symbol_found = false;
-
     for (i = qk_ucis_state.count; i > 0; i--) {
       register_code (KC_BSPC);
       unregister_code (KC_BSPC);
@@ -129,15 +228,17 @@ bool process_ucis (uint16_t keycode, keyrecord_t *record) {
       return false;
     }
 
+    char name[UCIS_MAX_SYMBOL_LENGTH + 1];
+    const qk_ucis_symbol_t *symbol = NULL;
+
+    /* the terminating key is not part of the name */
+    if (ucis_typed_name(name, qk_ucis_state.count - 1))
+      symbol = ucis_lookup(name);
+
     unicode_input_start();
-    for (i = 0; ucis_symbol_table[i].symbol; i++) {
-      if (is_uni_seq (ucis_symbol_table[i].symbol)) {
-        symbol_found = true;
-        register_ucis(ucis_symbol_table[i].code + 2);
-        break;
-      }
-    }
-    if (!symbol_found) {
+    if (symbol) {
+      register_ucis(symbol->code + 2);
+    } else {
       qk_ucis_symbol_fallback();
     }
     unicode_input_finish();
@@ -31,10 +31,14 @@ typedef struct {
 
 typedef struct {
   uint8_t count;
-  uint16_t codes[UCIS_MAX_SYMBOL_LENGTH];
+  uint16_t codes[UCIS_MAX_SYMBOL_LENGTH + 1]; // plus the terminating key
   bool in_progress:1;
 } qk_ucis_state_t;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern qk_ucis_state_t qk_ucis_state;
 
 #define UCIS_TABLE(...) {__VA_ARGS__, {NULL, NULL}}
@@ -46,6 +50,11 @@ void qk_ucis_start(void);
 void qk_ucis_start_user(void);
 void qk_ucis_symbol_fallback (void);
 void register_ucis(const char *hex);
+uint16_t qk_ucis_completions(const qk_ucis_symbol_t **first);
 bool process_ucis (uint16_t keycode, keyrecord_t *record);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
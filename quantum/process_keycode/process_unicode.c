@@ -26,9 +26,8 @@ bool process_unicode(uint16_t keycode, keyrecord_t *record) {
       first_flag = 1;
     }
     uint16_t unicode = keycode & 0x7FFF;
-    unicode_input_start();
-    register_hex(unicode);
-    unicode_input_finish();
+    // key events are held while output is busy, so the queue has room
+    send_unicode_codepoint(unicode);
   }
   return true;
 }
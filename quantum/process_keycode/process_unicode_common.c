@@ -16,10 +16,17 @@
 
 #include "process_unicode_common.h"
 #include "eeprom.h"
+#include <string.h>
 
 static uint8_t input_mode;
 uint8_t mods;
 
+/* Set while the streaming output asks the hooks below for the steps of a
+ * session, see uc_run_hook() */
+static bool uc_planning;
+static void uc_plan_session_start(void);
+static void uc_plan_session_finish(void);
+
 void set_unicode_input_mode(uint8_t os_target)
 {
   input_mode = os_target;
@@ -32,6 +39,11 @@ uint8_t get_unicode_input_mode(void) {
 
 __attribute__((weak))
 void unicode_input_start (void) {
+  if (uc_planning) {
+    uc_plan_session_start();
+    return;
+  }
+
   // save current mods
   mods = keyboard_report->mods;
 
@@ -76,6 +88,11 @@ void unicode_input_start (void) {
 
 __attribute__((weak))
 void unicode_input_finish (void) {
+  if (uc_planning) {
+    uc_plan_session_finish();
+    return;
+  }
+
   switch(input_mode) {
     case UC_OSX:
     case UC_WIN:
@@ -120,3 +137,305 @@ void register_hex(uint16_t hex) {
     unregister_code(hex_to_keycode(digit));
   }
 }
+
+/* Streaming output
+ *
+ * Code points are queued by send_unicode_codepoint()/send_unicode_string()
+ * and typed out by unicode_task(), one keyboard report per call, so long
+ * strings never stall the scan loop. Every planned step is a complete
+ * report (modifiers plus at most one key), the user's modifiers are saved
+ * and restored once per batch, and on macOS consecutive code points share
+ * one input session.
+ */
+
+/* Steps that are not a key */
+#define UC_STEP_DELAY  0xFF
+#define UC_STEP_START  0xFE   /* call unicode_input_start() */
+#define UC_STEP_FINISH 0xFD   /* call unicode_input_finish() */
+
+typedef struct {
+  uint8_t mods;
+  uint8_t key;
+} uc_step_t;
+
+/* the start steps + delay + 2 * 8 digits + the finish steps */
+#define UC_PLAN_SIZE 24
+
+static uint32_t uc_queue[UNICODE_QUEUE_SIZE];
+static uint8_t uc_queue_head;
+static uint8_t uc_queue_tail;
+
+static uc_step_t uc_plan[UC_PLAN_SIZE];
+static uint8_t uc_plan_len;
+static uint8_t uc_plan_pos;
+/* where uc_plan_step() puts the next step, the end of the plan unless a
+ * hook is adding its steps */
+static uint8_t uc_plan_at;
+
+static bool uc_batch_open;
+static bool uc_session_open;
+static uint8_t uc_saved_mods;
+static uint8_t uc_held_key;
+static bool uc_delaying;
+static uint16_t uc_delay_timer;
+
+static inline bool uc_queue_empty(void) {
+  return uc_queue_head == uc_queue_tail;
+}
+
+static inline bool uc_queue_full(void) {
+  return (uint8_t)(uc_queue_head - uc_queue_tail) == UNICODE_QUEUE_SIZE;
+}
+
+static void uc_plan_step(uint8_t mods, uint8_t key) {
+  if (uc_plan_len == UC_PLAN_SIZE) {
+    return;
+  }
+  memmove(&uc_plan[uc_plan_at + 1], &uc_plan[uc_plan_at], (uc_plan_len - uc_plan_at) * sizeof(uc_step_t));
+  uc_plan[uc_plan_at].mods = mods;
+  uc_plan[uc_plan_at].key = key;
+  uc_plan_at++;
+  uc_plan_len++;
+}
+
+/* At least four digits, without leading zeros beyond that */
+static void uc_plan_hex(uint8_t mods, uint32_t hex) {
+  bool leading = true;
+  for (int8_t i = 7; i >= 0; i--) {
+    uint8_t digit = (hex >> (i * 4)) & 0xF;
+    if (leading && digit == 0 && i > 3) {
+      continue;
+    }
+    leading = false;
+    uc_plan_step(mods, hex_to_keycode(digit));
+    uc_plan_step(mods, KC_NO);
+  }
+}
+
+/* The default unicode_input_start() and unicode_input_finish() add these
+ * steps in place of their UC_STEP_START/UC_STEP_FINISH step. The delay
+ * after the start is planned separately, overridden hooks get it too.
+ */
+static void uc_plan_session_start(void) {
+  switch (input_mode) {
+  case UC_OSX:
+  case UC_OSX_RALT:
+    uc_plan_step(MOD_BIT(input_mode == UC_OSX ? KC_LALT : KC_RALT), KC_NO);
+    break;
+  case UC_LNX:
+    uc_plan_step(MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT), UNICODE_KEY_LNX);
+    uc_plan_step(0, KC_NO);
+    break;
+  case UC_WIN:
+    uc_plan_step(MOD_BIT(KC_LALT), KC_PPLS);
+    uc_plan_step(MOD_BIT(KC_LALT), KC_NO);
+    break;
+  case UC_WINC:
+    uc_plan_step(MOD_BIT(KC_RALT), KC_NO);
+    uc_plan_step(0, KC_NO);
+    uc_plan_step(0, UNICODE_KEY_WINC);
+    uc_plan_step(0, KC_NO);
+    break;
+  }
+}
+
+static void uc_plan_session_finish(void) {
+  switch (input_mode) {
+  case UC_LNX:
+    uc_plan_step(0, KC_SPC);
+    uc_plan_step(0, KC_NO);
+    break;
+  case UC_WIN:
+    uc_plan_step(0, KC_NO);
+    break;
+  }
+  /* macOS sessions are closed by restoring the user's modifiers */
+}
+
+/* Reached a UC_STEP_START/UC_STEP_FINISH step while streaming: the
+ * default hook replaces it with its steps, an overridden one types its
+ * own sequence right now, after the steps before it and before the ones
+ * after it.
+ */
+static void uc_run_hook(void (*hook)(void)) {
+  uc_plan_len--;
+  memmove(&uc_plan[uc_plan_pos], &uc_plan[uc_plan_pos + 1], (uc_plan_len - uc_plan_pos) * sizeof(uc_step_t));
+  uc_plan_at = uc_plan_pos;
+  uc_planning = true;
+  hook();
+  uc_planning = false;
+}
+
+static void uc_plan_next(void) {
+  uc_plan_len = 0;
+  uc_plan_pos = 0;
+  uc_plan_at = 0;
+
+  if (uc_queue_empty()) {
+    if (uc_batch_open) {
+      if (uc_session_open) {
+        uc_plan_step(0, UC_STEP_FINISH);
+      }
+      uc_plan_step(uc_saved_mods, KC_NO);
+      uc_batch_open = false;
+      uc_session_open = false;
+    }
+    return;
+  }
+
+  uint32_t code_point = uc_queue[uc_queue_tail & (UNICODE_QUEUE_SIZE - 1)];
+  uc_queue_tail++;
+
+  if (!uc_batch_open) {
+    uc_saved_mods = get_mods();
+    clear_weak_mods();
+    uc_batch_open = true;
+  }
+
+  switch (input_mode) {
+  case UC_OSX:
+  case UC_OSX_RALT: {
+    uint8_t mods = MOD_BIT(input_mode == UC_OSX ? KC_LALT : KC_RALT);
+    if (code_point > 0x10FFFF) {
+      break;
+    }
+    /* consecutive code points share one session */
+    if (!uc_session_open) {
+      uc_plan_step(0, UC_STEP_START);
+      uc_plan_step(0, UC_STEP_DELAY);
+      uc_session_open = true;
+    }
+    if (code_point > 0xFFFF) {
+      /* UTF-16 surrogate pair */
+      code_point -= 0x10000;
+      uc_plan_hex(mods, (code_point >> 10) + 0xD800);
+      uc_plan_hex(mods, (code_point & 0x3FF) + 0xDC00);
+    } else {
+      uc_plan_hex(mods, code_point);
+    }
+    break;
+  }
+  case UC_LNX:
+  case UC_WIN:
+  case UC_WINC:
+    if (input_mode == UC_LNX && code_point > 0xFFFFF) {
+      break;
+    }
+    uc_plan_step(0, UC_STEP_START);
+    uc_plan_step(0, UC_STEP_DELAY);
+    uc_plan_hex(input_mode == UC_WIN ? MOD_BIT(KC_LALT) : 0, code_point);
+    uc_plan_step(0, UC_STEP_FINISH);
+    break;
+  }
+}
+
+bool unicode_busy(void) {
+  return uc_plan_pos < uc_plan_len || uc_batch_open || !uc_queue_empty();
+}
+
+void unicode_task(void) {
+  /* the last step is still waiting for the host */
+  if (!host_keyboard_ready()) {
+    return;
+  }
+
+  if (uc_plan_pos == uc_plan_len) {
+    uc_plan_next();
+    if (uc_plan_len == 0) {
+      return;
+    }
+  }
+
+  uc_step_t step = uc_plan[uc_plan_pos];
+
+  if (step.key == UC_STEP_START || step.key == UC_STEP_FINISH) {
+    /* the report state the hook starts from */
+    if (uc_held_key) {
+      del_key(uc_held_key);
+      uc_held_key = 0;
+    }
+    set_mods(step.mods);
+    uc_run_hook(step.key == UC_STEP_START ? unicode_input_start : unicode_input_finish);
+    /* an overridden hook typed its own reports instead of planning
+     * steps, the next step goes out on the next scan */
+    if (uc_plan_at == uc_plan_pos || uc_plan_pos == uc_plan_len) {
+      return;
+    }
+    step = uc_plan[uc_plan_pos];
+  }
+
+  if (step.key == UC_STEP_DELAY) {
+    if (!uc_delaying) {
+      uc_delay_timer = timer_read();
+      uc_delaying = true;
+    }
+    if (timer_elapsed(uc_delay_timer) < UNICODE_TYPE_DELAY) {
+      return;
+    }
+    uc_delaying = false;
+    step = uc_plan[++uc_plan_pos];
+  }
+
+  if (uc_held_key) {
+    del_key(uc_held_key);
+  }
+  if (step.key) {
+    add_key(step.key);
+  }
+  uc_held_key = step.key;
+  set_mods(step.mods);
+  send_keyboard_report();
+  uc_plan_pos++;
+}
+
+/* Returns false, without queueing, while the queue is full; call again
+ * after unicode_task() has typed some of it */
+bool send_unicode_codepoint(uint32_t code_point) {
+  if (uc_queue_full()) {
+    return false;
+  }
+  uc_queue[uc_queue_head & (UNICODE_QUEUE_SIZE - 1)] = code_point;
+  uc_queue_head++;
+  return true;
+}
+
+/* Returns NULL once the whole string is queued, otherwise the part that
+ * did not fit, to be passed in again from a later scan */
+const char *send_unicode_string(const char *str) {
+  while (*str) {
+    const char *next = str;
+    uint8_t c = *next++;
+    uint32_t code_point;
+    uint8_t extra;
+
+    if (c < 0x80) {
+      code_point = c;
+      extra = 0;
+    } else if ((c & 0xE0) == 0xC0) {
+      code_point = c & 0x1F;
+      extra = 1;
+    } else if ((c & 0xF0) == 0xE0) {
+      code_point = c & 0x0F;
+      extra = 2;
+    } else if ((c & 0xF8) == 0xF0) {
+      code_point = c & 0x07;
+      extra = 3;
+    } else {
+      /* stray continuation or invalid byte */
+      str = next;
+      continue;
+    }
+
+    for (; extra > 0; extra--) {
+      if ((*next & 0xC0) != 0x80) {
+        break;
+      }
+      code_point = (code_point << 6) | (*next++ & 0x3F);
+    }
+    if (extra == 0 && !send_unicode_codepoint(code_point)) {
+      return str;
+    }
+    str = next;
+  }
+  return NULL;
+}
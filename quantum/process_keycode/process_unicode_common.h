@@ -23,15 +23,45 @@
 #define UNICODE_TYPE_DELAY 10
 #endif
 
+// Code points buffered for streaming output, must be a power of two
+#ifndef UNICODE_QUEUE_SIZE
+#define UNICODE_QUEUE_SIZE 16
+#endif
+
+#if (UNICODE_QUEUE_SIZE & (UNICODE_QUEUE_SIZE - 1)) != 0 || UNICODE_QUEUE_SIZE > 128
+#error "UNICODE_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+// Keys that open an input session in UC_LNX and UC_WINC modes
+#ifndef UNICODE_KEY_LNX
+#define UNICODE_KEY_LNX KC_U
+#endif
+#ifndef UNICODE_KEY_WINC
+#define UNICODE_KEY_WINC KC_U
+#endif
+
 __attribute__ ((unused))
 static uint8_t input_mode;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void set_unicode_input_mode(uint8_t os_target);
 uint8_t get_unicode_input_mode(void);
 void unicode_input_start(void);
 void unicode_input_finish(void);
 void register_hex(uint16_t hex);
 
+bool send_unicode_codepoint(uint32_t code_point);
+const char *send_unicode_string(const char *str);
+bool unicode_busy(void);
+void unicode_task(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #define UC_OSX 0  // Mac OS X
 #define UC_LNX 1  // Linux
 #define UC_WIN 2  // Windows 'HexNumpad'
@@ -643,6 +643,17 @@ const uint8_t ascii_to_keycode_lut[0x80] PROGMEM = {
     KC_X, KC_Y, KC_Z, KC_LBRC, KC_BSLS, KC_RBRC, KC_GRV, KC_DEL
 };
 
+/* send_string() only returns once the whole string is typed, so unlike
+ * the scan loop it waits for the host: a character is not started before
+ * the reports of the last one have been taken. The wait is bounded, a host
+ * that stops polling holds the next report back in the driver instead. */
+static void send_string_wait_for_host(void) {
+  uint16_t start = timer_read();
+  while (!host_keyboard_ready() && timer_elapsed(start) < SEND_STRING_HOST_TIMEOUT) {
+    wait_ms(1);
+  }
+}
+
 void send_string(const char *str) {
   send_string_with_delay(str, 0);
 }
@@ -655,6 +666,7 @@ void send_string_with_delay(const char *str, uint8_t interval) {
     while (1) {
         char ascii_code = *str;
         if (!ascii_code) break;
+        send_string_wait_for_host();
         if (ascii_code == 1) {
           // tap
           uint8_t keycode = *(++str);
@@ -681,6 +693,7 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
     while (1) {
         char ascii_code = pgm_read_byte(str);
         if (!ascii_code) break;
+        send_string_wait_for_host();
         if (ascii_code == 1) {
           // tap
           uint8_t keycode = pgm_read_byte(++str);
@@ -705,6 +718,7 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
 
 void send_char(char ascii_code) {
   uint8_t keycode;
+  send_string_wait_for_host();
   keycode = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
   if (pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii_code])) {
       register_code(KC_LSFT);
@@ -781,6 +795,14 @@ void matrix_init_quantum() {
   matrix_init_kb();
 }
 
+#ifdef UNICODE_COMMON_ENABLE
+// Keys pressed while a Unicode string is typed out would end up in its
+// reports, so they wait until it is done
+bool keyboard_output_busy(void) {
+  return unicode_busy();
+}
+#endif
+
 void matrix_scan_quantum() {
   #ifdef AUDIO_ENABLE
     matrix_scan_music();
@@ -794,6 +816,10 @@ void matrix_scan_quantum() {
     matrix_scan_combo();
   #endif
 
+  #ifdef UNICODE_COMMON_ENABLE
+    unicode_task();
+  #endif
+
   #if defined(BACKLIGHT_ENABLE) && defined(BACKLIGHT_PIN)
     backlight_task();
   #endif
@@ -127,6 +127,10 @@ extern uint32_t default_layer_state;
 #define SS_LSFT(string) SS_DOWN(X_LSHIFT) string SS_UP(X_LSHIFT)
 
 #define SEND_STRING(str) send_string_P(PSTR(str))
+// How long send_string() waits at most for the host before each character (ms)
+#ifndef SEND_STRING_HOST_TIMEOUT
+#define SEND_STRING_HOST_TIMEOUT 100
+#endif
 extern const bool ascii_to_shift_lut[0x80];
 extern const uint8_t ascii_to_keycode_lut[0x80];
 void send_string(const char *str);
@@ -13,10 +13,8 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <math.h>
-#include <avr/eeprom.h>
-#include <avr/interrupt.h>
-#include <util/delay.h>
+#include "eeprom.h"
+#include "wait.h"
 #include "progmem.h"
 #include "timer.h"
 #include "rgblight.h"
@@ -24,6 +22,7 @@
 #include "led_tables.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 __attribute__ ((weak))
 const uint8_t RGBLED_BREATHING_INTERVALS[] PROGMEM = {30, 20, 10, 5};
@@ -44,6 +43,15 @@ rgblight_config_t inmem_config;
 LED_TYPE led[RGBLED_NUM];
 uint8_t rgblight_inited = 0;
 bool rgblight_timer_enabled = false;
+// What the strip shows. It keeps showing the last data it got, so only
+// the LEDs up to the last one that changed have to be sent again.
+static LED_TYPE led_shown[RGBLED_NUM];
+static bool led_shown_valid = false;
+#ifdef RGBLIGHT_MAX_FPS
+static uint16_t last_frame_time;
+static bool frame_pending = false;
+#endif
+
 struct locked_rgb_led
 {
   int8_t index;
@@ -165,10 +173,17 @@ void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
     g = val;
     b = val;
   } else {
+    uint8_t sector = 0;
+    while (hue >= 60) {
+      hue -= 60;
+      sector++;
+    }
     base = ((255 - sat) * val) >> 8;
-    color = (val - base) * (hue % 60) / 60;
+    // (val - base) * hue / 60, the product is at most 255 * 59, where
+    // multiplying by 17477 / 2^20 gives the same result as dividing
+    color = ((uint32_t)((val - base) * hue) * 17477) >> 20;
 
-    switch (hue / 60) {
+    switch (sector) {
       case 0:
         r = val;
         g = base + color;
@@ -257,6 +272,9 @@ void rgblight_init(void) {
   }
   eeconfig_debug_rgblight(); // display current eeprom values
 
+  // the strip may show anything, send all of the first frame
+  led_shown_valid = false;
+
   #ifdef RGBLIGHT_ANIMATIONS
     rgblight_timer_init(); // setup the timer
   #endif
@@ -382,7 +400,7 @@ void rgblight_disable(void) {
   #ifdef RGBLIGHT_ANIMATIONS
     rgblight_timer_disable();
   #endif
-  _delay_ms(50);
+  wait_ms(50);
   rgblight_set();
 }
 
@@ -512,6 +530,27 @@ void rgblight_sethsv_at(uint16_t hue, uint8_t sat, uint8_t val, uint8_t index) {
   rgblight_setrgb_at(tmp_led.r, tmp_led.g, tmp_led.b, index);
 }
 
+uint16_t rgblight_take_frame(void) {
+  uint16_t count = RGBLED_NUM;
+  if (led_shown_valid) {
+    while (count > 0 && memcmp(&led[count - 1], &led_shown[count - 1], sizeof(LED_TYPE)) == 0) {
+      count--;
+    }
+  }
+#ifdef RGBLIGHT_MAX_FPS
+  frame_pending = false;
+  if (count > 0 && led_shown_valid && timer_elapsed(last_frame_time) < 1000 / RGBLIGHT_MAX_FPS) {
+    // rgblight_task sends it when it's time
+    frame_pending = true;
+    return 0;
+  }
+  last_frame_time = timer_read();
+#endif
+  memcpy(led_shown, led, count * sizeof(LED_TYPE));
+  led_shown_valid = true;
+  return count;
+}
+
 #ifndef RGBLIGHT_CUSTOM_DRIVER
 void rgblight_set(void) {
   if (rgblight_config.enable) {
@@ -524,21 +563,20 @@ void rgblight_set(void) {
       led[current->index].b = current->b;
       current = current->next;
     }
-    #ifdef RGBW
-      ws2812_setleds_rgbw(led, RGBLED_NUM);
-    #else
-      ws2812_setleds(led, RGBLED_NUM);
-    #endif
   } else {
     for (uint8_t i = 0; i < RGBLED_NUM; i++) {
       led[i].r = 0;
       led[i].g = 0;
       led[i].b = 0;
     }
+  }
+
+  uint16_t count = rgblight_take_frame();
+  if (count > 0) {
     #ifdef RGBW
-      ws2812_setleds_rgbw(led, RGBLED_NUM);
+      ws2812_setleds_rgbw(led, count);
     #else
-      ws2812_setleds(led, RGBLED_NUM);
+      ws2812_setleds(led, count);
     #endif
   }
 }
@@ -585,6 +623,11 @@ void rgblight_show_solid_color(uint8_t r, uint8_t g, uint8_t b) {
 }
 
 void rgblight_task(void) {
+#ifdef RGBLIGHT_MAX_FPS
+  if (frame_pending && timer_elapsed(last_frame_time) >= 1000 / RGBLIGHT_MAX_FPS) {
+    rgblight_set();
+  }
+#endif
   if (rgblight_timer_enabled) {
     // mode = 1, static light, do nothing here
     if (rgblight_config.mode >= 2 && rgblight_config.mode <= 5) {
@@ -610,20 +653,47 @@ void rgblight_task(void) {
 }
 
 // Effects
+
+// exp(sin(pos / 255 * PI)) for the first half of the breathing cycle,
+// the second half mirrors it, scaled from 1 - e to 0 - 255
+// http://sean.voisen.org/blog/2011/10/breathing-led-with-arduino/
+static const uint8_t RGBLED_BREATHING_CURVE[] PROGMEM = {
+  0, 2, 4, 6, 7, 9, 11, 13, 15, 17, 19, 21, 24, 26, 28, 30,
+  32, 34, 37, 39, 41, 43, 46, 48, 50, 53, 55, 57, 60, 62, 65, 67,
+  69, 72, 74, 77, 80, 82, 85, 87, 90, 92, 95, 98, 100, 103, 105, 108,
+  111, 113, 116, 119, 121, 124, 127, 129, 132, 135, 137, 140, 143, 145, 148, 151,
+  153, 156, 158, 161, 164, 166, 169, 171, 174, 176, 179, 181, 184, 186, 188, 191,
+  193, 195, 198, 200, 202, 204, 207, 209, 211, 213, 215, 217, 219, 221, 223, 224,
+  226, 228, 229, 231, 233, 234, 236, 237, 239, 240, 241, 242, 244, 245, 246, 247,
+  248, 249, 249, 250, 251, 252, 252, 253, 253, 254, 254, 254, 255, 255, 255, 255
+};
+
+#define BREATHE_E 2.718281828
+#define BREATHE_SCALE (RGBLIGHT_EFFECT_BREATHE_MAX / (BREATHE_E - 1 / BREATHE_E))
+// The brightness is BREATHE_OFFSET + curve * BREATHE_SLOPE in 8.8 fixed
+// point, the compiler works out both from the floating point settings
+#define BREATHE_OFFSET ((int32_t)((1 - RGBLIGHT_EFFECT_BREATHE_CENTER / BREATHE_E) * BREATHE_SCALE * 256))
+#define BREATHE_SLOPE ((int32_t)((BREATHE_E - 1) * BREATHE_SCALE * 256 / 255 + 0.5))
+
 void rgblight_effect_breathing(uint8_t interval) {
   static uint8_t pos = 0;
   static uint16_t last_timer = 0;
-  float val;
+  int32_t val;
 
   if (timer_elapsed(last_timer) < pgm_read_byte(&RGBLED_BREATHING_INTERVALS[interval])) {
     return;
   }
   last_timer = timer_read();
 
-  // http://sean.voisen.org/blog/2011/10/breathing-led-with-arduino/
-  val = (exp(sin((pos/255.0)*M_PI)) - RGBLIGHT_EFFECT_BREATHE_CENTER/M_E)*(RGBLIGHT_EFFECT_BREATHE_MAX/(M_E-1/M_E));
+  uint8_t curve = pgm_read_byte(&RGBLED_BREATHING_CURVE[pos < 128 ? pos : 255 - pos]);
+  val = (BREATHE_OFFSET + curve * BREATHE_SLOPE + 128) >> 8;
+  if (val < 0) {
+    val = 0;
+  } else if (val > 255) {
+    val = 255;
+  }
   rgblight_sethsv_noeeprom(rgblight_config.hue, rgblight_config.sat, val);
-  pos = (pos + 1) % 256;
+  pos++;
 }
 void rgblight_effect_rainbow_mood(uint8_t interval) {
   static uint16_t current_hue = 0;
@@ -634,7 +704,9 @@ void rgblight_effect_rainbow_mood(uint8_t interval) {
   }
   last_timer = timer_read();
   rgblight_sethsv_noeeprom(current_hue, rgblight_config.sat, rgblight_config.val);
-  current_hue = (current_hue + 1) % 360;
+  if (++current_hue == 360) {
+    current_hue = 0;
+  }
 }
 void rgblight_effect_rainbow_swirl(uint8_t interval) {
   static uint16_t current_hue = 0;
@@ -645,16 +717,22 @@ void rgblight_effect_rainbow_swirl(uint8_t interval) {
     return;
   }
   last_timer = timer_read();
+  hue = current_hue;
   for (i = 0; i < RGBLED_NUM; i++) {
-    hue = (360 / RGBLED_NUM * i + current_hue) % 360;
     sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    hue += 360 / RGBLED_NUM;
+    if (hue >= 360) {
+      hue -= 360;
+    }
   }
   rgblight_set();
 
-  if (interval % 2) {
-    current_hue = (current_hue + 1) % 360;
+  if (interval & 1) {
+    if (++current_hue == 360) {
+      current_hue = 0;
+    }
   } else {
-    if (current_hue - 1 < 0) {
+    if (current_hue == 0) {
       current_hue = 359;
     } else {
       current_hue = current_hue - 1;
@@ -667,7 +745,7 @@ void rgblight_effect_snake(uint8_t interval) {
   uint8_t i, j;
   int8_t k;
   int8_t increment = 1;
-  if (interval % 2) {
+  if (interval & 1) {
     increment = -1;
   }
   if (timer_elapsed(last_timer) < pgm_read_byte(&RGBLED_SNAKE_INTERVALS[interval / 2])) {
@@ -696,7 +774,9 @@ void rgblight_effect_snake(uint8_t interval) {
       pos -= 1;
     }
   } else {
-    pos = (pos + 1) % RGBLED_NUM;
+    if (++pos == RGBLED_NUM) {
+      pos = 0;
+    }
   }
 }
 void rgblight_effect_knight(uint8_t interval) {
@@ -718,8 +798,11 @@ void rgblight_effect_knight(uint8_t interval) {
     led[i].b = 0;
   }
   // Determine which LEDs should be lit up
-  for (i = 0; i < RGBLIGHT_EFFECT_KNIGHT_LED_NUM; i++) {
-    cur = (i + RGBLIGHT_EFFECT_KNIGHT_OFFSET) % RGBLED_NUM;
+  cur = RGBLIGHT_EFFECT_KNIGHT_OFFSET % RGBLED_NUM;
+  for (i = 0; i < RGBLIGHT_EFFECT_KNIGHT_LED_NUM; i++, cur++) {
+    if (cur == RGBLED_NUM) {
+      cur = 0;
+    }
 
     if (i >= low_bound && i <= high_bound) {
       sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[cur]);
@@ -751,10 +834,16 @@ void rgblight_effect_christmas(void) {
     return;
   }
   last_timer = timer_read();
-  current_offset = (current_offset + 1) % 2;
+  current_offset ^= 1;
+  uint8_t step = 0;
+  bool green = current_offset;
   for (i = 0; i < RGBLED_NUM; i++) {
-    hue = 0 + ((i/RGBLIGHT_EFFECT_CHRISTMAS_STEP + current_offset) % 2) * 120;
+    hue = green ? 120 : 0;
     sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    if (++step == RGBLIGHT_EFFECT_CHRISTMAS_STEP) {
+      step = 0;
+      green = !green;
+    }
   }
   rgblight_set();
 }
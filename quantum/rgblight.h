@@ -64,12 +64,19 @@
 #define RGBLIGHT_VAL_STEP 17
 #endif
 
+// RGBLIGHT_MAX_FPS limits how often a frame is sent to the strip, the
+// ones that come too soon are sent later from rgblight_task()
+#if defined(RGBLIGHT_MAX_FPS) && !defined(RGBLIGHT_ANIMATIONS)
+#error "RGBLIGHT_MAX_FPS needs RGBLIGHT_ANIMATIONS"
+#endif
+
 #define RGBLED_TIMER_TOP F_CPU/(256*64)
 // #define RGBLED_TIMER_TOP 0xFF10
 
 #include <stdint.h>
 #include <stdbool.h>
 #include "eeconfig.h"
+#include "progmem.h"
 #ifndef RGBLIGHT_CUSTOM_DRIVER
 #include "ws2812.h"
 #endif
@@ -105,6 +112,11 @@ void rgblight_step_reverse(void);
 uint32_t rgblight_get_mode(void);
 void rgblight_mode(uint8_t mode);
 void rgblight_set(void);
+// How many LEDs from the start of the strip have to be sent for it to
+// show led[], they are counted as sent then. 0 when it shows led[]
+// already, or when RGBLIGHT_MAX_FPS holds the frame back. For the
+// rgblight_set() of a custom driver.
+uint16_t rgblight_take_frame(void);
 void rgblight_update_dword(uint32_t dword);
 void rgblight_increase_hue(void);
 void rgblight_decrease_hue(void);
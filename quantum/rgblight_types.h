@@ -23,7 +23,7 @@
 #ifndef RGBLIGHT_TYPES
 #define RGBLIGHT_TYPES
 
-#include <avr/io.h>
+#include <stdint.h>
 
 #ifdef RGBW
   #define LED_TYPE struct cRGBW
@@ -53,8 +53,7 @@ void init_byte_stuffer(void) {
     }
 }
 
-void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
-    byte_stuffer_state_t* state = &states[link];
+static void recv_byte(byte_stuffer_state_t* state, uint8_t link, uint8_t data) {
     // Start of a new frame
     if (state->next_zero == 0) {
         state->next_zero = data;
@@ -102,41 +101,81 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
     }
 }
 
-static void send_block(uint8_t link, uint8_t* start, uint8_t* end, uint8_t num_non_zero) {
-    send_data(link, &num_non_zero, 1);
-    if (end > start) {
-        send_data(link, start, end-start);
+void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
+    recv_byte(&states[link], link, data);
+}
+
+void byte_stuffer_recv(uint8_t link, const uint8_t* data, uint16_t size) {
+    byte_stuffer_state_t* state = &states[link];
+    const uint8_t* end = data + size;
+    while (data < end) {
+        // The bytes in the middle of a block are plain data, so copy them
+        // in one go, and leave the block boundaries to recv_byte
+        if (state->next_zero > 1) {
+            uint16_t run = state->next_zero - 1;
+            if (run > end - data) {
+                run = end - data;
+            }
+            if (run > MAX_FRAME_SIZE - state->data_pos) {
+                run = MAX_FRAME_SIZE - state->data_pos;
+            }
+            uint8_t* dest = state->data + state->data_pos;
+            uint16_t copied = 0;
+            while (copied < run && data[copied] != 0) {
+                dest[copied] = data[copied];
+                copied++;
+            }
+            state->next_zero -= copied;
+            state->data_pos += copied;
+            data += copied;
+            if (data == end) {
+                break;
+            }
+        }
+        recv_byte(state, link, *data++);
     }
 }
 
+// The worst case for a frame of MAX_FRAME_SIZE, one extra code byte for
+// every 254 non-zero bytes, plus the first code byte and the final zero
+#define MAX_STUFFED_SIZE (MAX_FRAME_SIZE + MAX_FRAME_SIZE / 254 + 2)
+
+// Only the serial link thread sends, so one buffer serves both links
+static uint8_t send_buffer[MAX_STUFFED_SIZE];
+
 void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
-    const uint8_t zero = 0;
-    if (size > 0) {
-        uint16_t num_non_zero = 1;
+    // The receiver can't take frames bigger than MAX_FRAME_SIZE anyway
+    if (size > 0 && size <= MAX_FRAME_SIZE) {
+        // Stuff the whole frame into the buffer, so that it can be sent
+        // with a single call
+        uint8_t* out = send_buffer;
+        uint8_t* code = out++;
+        uint8_t num_non_zero = 1;
         uint8_t* end = data + size;
-        uint8_t* start = data;
         while (data < end) {
             if (num_non_zero == 0xFF) {
                 // There's more data after big non-zero block
-                // So send it, and start a new block
-                send_block(link, start, data, num_non_zero);
-                start = data;
+                // So end it, and start a new block
+                *code = num_non_zero;
+                code = out++;
                 num_non_zero = 1;
             }
             else {
                 if (*data == 0) {
-                    // A zero encountered, so send the block
-                    send_block(link, start, data, num_non_zero);
-                    start = data + 1;
+                    // A zero encountered, so end the block
+                    *code = num_non_zero;
+                    code = out++;
                     num_non_zero = 1;
                 }
                 else {
+                    *out++ = *data;
                     num_non_zero++;
                 }
                 ++data;
             }
         }
-        send_block(link, start, data, num_non_zero);
-        send_data(link, &zero, 1);
+        *code = num_non_zero;
+        *out++ = 0;
+        send_data(link, send_buffer, out - send_buffer);
     }
 }
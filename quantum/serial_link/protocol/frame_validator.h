@@ -31,4 +31,15 @@ void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size);
 // The buffer pointed to by the data needs 4 additional bytes
 void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size);
 
+// Frames of up to SERIAL_LINK_CRC16_MAX_SIZE bytes get a 16 bit CRC
+// instead of a 32 bit one when it's defined, it has to be the same on
+// all the halves
+// #define SERIAL_LINK_CRC16_MAX_SIZE 32
+
+#ifdef SERIAL_LINK_CRC_HARDWARE
+// Reflected CRC-32 with polynomial 0x04C11DB7, initial value 0xFFFFFFFF
+// and the result inverted, computed by the CRC unit of the MCU
+uint32_t serial_link_crc32_hardware(const uint8_t* data, uint32_t size);
+#endif
+
 #endif
@@ -25,12 +25,29 @@ SOFTWARE.
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
 #include "serial_link/protocol/triple_buffered_object.h"
+#include "serial_link/protocol/byte_stuffer.h"
 #include <string.h>
 
 #define MAX_REMOTE_OBJECTS 16
 static remote_object_t* remote_objects[MAX_REMOTE_OBJECTS];
 static uint32_t num_remote_objects = 0;
 
+// Everything sent to the same destination in one update goes in a
+// single frame, as a list of records. A record starts with the id of an
+// object and its size follows from the id. Reliable objects have
+// RELIABLE_ID_FLAG set in the id and a sequence number after it. An
+// ACK_ID record acknowledges one reliable object with its id and
+// sequence number.
+#define RELIABLE_ID_FLAG 0x80
+#define ACK_ID 0x7F
+#define ACK_RECORD_SIZE 3
+
+// Room for the destination the router adds and the CRC
+#define MAX_BATCH_SIZE (MAX_FRAME_SIZE - 5)
+
+static uint8_t batch[MAX_FRAME_SIZE];
+static uint16_t batch_size = 0;
+
 void reinitialize_serial_link_transport(void) {
     num_remote_objects = 0;
 }
@@ -40,6 +57,9 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     for(i=0;i<_num_remote_objects;i++) {
         remote_object_t* obj = _remote_objects[i];
         remote_objects[num_remote_objects++] = obj;
+        if (obj->reliable) {
+            memset(obj->reliable, 0, sizeof(reliable_state_t));
+        }
         if (obj->object_type == MASTER_TO_ALL_SLAVES) {
             triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
             triple_buffer_init(tb);
@@ -73,56 +93,232 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     }
 }
 
+static void recv_ack(uint8_t from, uint8_t id, uint8_t seq) {
+    if (id >= num_remote_objects || !remote_objects[id]->reliable) {
+        return;
+    }
+    remote_object_t* obj = remote_objects[id];
+    reliable_sender_t* sender;
+    if (obj->object_type == SLAVE_TO_MASTER) {
+        sender = &obj->reliable->senders[0];
+    }
+    else if (obj->object_type == MASTER_TO_SINGLE_SLAVE && from > 0 && from <= NUM_SLAVES) {
+        sender = &obj->reliable->senders[from - 1];
+    }
+    else {
+        return;
+    }
+    if (sender->seq == seq) {
+        sender->acked = true;
+    }
+}
+
+static void recv_object(uint8_t from, uint8_t* record) {
+    uint8_t id = record[0] & ~RELIABLE_ID_FLAG;
+    bool reliable = record[0] & RELIABLE_ID_FLAG;
+    uint8_t* data = record + (reliable ? 2 : 1);
+    remote_object_t* obj = remote_objects[id];
+    uint8_t* start;
+    reliable_receiver_t* receiver = NULL;
+    if (obj->object_type == MASTER_TO_ALL_SLAVES) {
+        start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
+    }
+    else if(obj->object_type == SLAVE_TO_MASTER) {
+        if (from == 0 || from > NUM_SLAVES) {
+            return;
+        }
+        start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
+        start += (from - 1) * REMOTE_OBJECT_SIZE(obj->object_size);
+        if (obj->reliable) {
+            receiver = &obj->reliable->receivers[from - 1];
+        }
+    }
+    else {
+        start = obj->buffer + NUM_SLAVES * LOCAL_OBJECT_SIZE(obj->object_size);
+        if (obj->reliable) {
+            receiver = &obj->reliable->receivers[0];
+        }
+    }
+    if (reliable) {
+        if (!receiver) {
+            return;
+        }
+        // A repeat is written again too, the acknowledgement for
+        // it may have been lost
+        receiver->seq = record[1];
+        receiver->ack_pending = true;
+    }
+    triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
+    void* ptr = triple_buffer_begin_write_internal(obj->object_size, tb);
+    memcpy(ptr, data, obj->object_size);
+    triple_buffer_end_write_internal(tb);
+}
+
+// The size of a record starting with the given id, 0 for an unknown id
+static uint16_t record_size(uint8_t id) {
+    if (id == ACK_ID) {
+        return ACK_RECORD_SIZE;
+    }
+    uint16_t header = 1;
+    if (id & RELIABLE_ID_FLAG) {
+        id &= ~RELIABLE_ID_FLAG;
+        header = 2;
+    }
+    if (id >= num_remote_objects) {
+        return 0;
+    }
+    return header + remote_objects[id]->object_size;
+}
+
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
-    uint8_t id = data[size-1];
-    if (id < num_remote_objects) {
-        remote_object_t* obj = remote_objects[id];
-        if (obj->object_size == size - 1) {
-            uint8_t* start;
-            if (obj->object_type == MASTER_TO_ALL_SLAVES) {
-                start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
-            }
-            else if(obj->object_type == SLAVE_TO_MASTER) {
-                start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
-                start += (from - 1) * REMOTE_OBJECT_SIZE(obj->object_size);
-            }
-            else {
-                start = obj->buffer + NUM_SLAVES * LOCAL_OBJECT_SIZE(obj->object_size);
-            }
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-            void* ptr = triple_buffer_begin_write_internal(obj->object_size, tb);
-            memcpy(ptr, data, size - 1);
-            triple_buffer_end_write_internal(tb);
+    // Check the whole frame first, so that nothing of a frame with
+    // records that don't add up is used
+    uint16_t pos = 0;
+    while (pos < size) {
+        uint16_t record = record_size(data[pos]);
+        if (record == 0 || record > size - pos) {
+            return;
+        }
+        pos += record;
+    }
+    for (pos = 0; pos < size; pos += record_size(data[pos])) {
+        if (data[pos] == ACK_ID) {
+            recv_ack(from, data[pos + 1], data[pos + 2]);
+        }
+        else {
+            recv_object(from, data + pos);
         }
     }
 }
 
-void update_transport(void) {
+static void flush_batch(uint8_t dest) {
+    if (batch_size > 0) {
+        router_send_frame(dest, batch, batch_size);
+        batch_size = 0;
+    }
+}
+
+// Returns room for a record in the frame to dest, sending the frame
+// first when the record doesn't fit anymore
+static uint8_t* add_record(uint8_t dest, uint16_t size) {
+    if (batch_size + size > MAX_BATCH_SIZE) {
+        flush_batch(dest);
+    }
+    uint8_t* record = batch + batch_size;
+    batch_size += size;
+    return record;
+}
+
+static void send_reliable(remote_object_t* obj, uint8_t id, uint8_t dest, reliable_sender_t* sender, uint32_t now) {
+    uint8_t* record = add_record(dest, obj->object_size + 2);
+    record[0] = id | RELIABLE_ID_FLAG;
+    record[1] = sender->seq;
+    memcpy(record + 2, sender->frame, obj->object_size);
+    sender->sent_time = now;
+}
+
+static void send_object(remote_object_t* obj, uint8_t id, uint8_t dest, triple_buffer_object_t* tb, reliable_sender_t* sender, uint32_t now) {
+    uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size, tb);
+    if (!sender) {
+        if (ptr) {
+            uint8_t* record = add_record(dest, obj->object_size + 1);
+            record[0] = id;
+            memcpy(record + 1, ptr, obj->object_size);
+        }
+    }
+    else if (ptr) {
+        sender->frame = ptr;
+        sender->seq++;
+        sender->acked = false;
+        sender->timeout = SERIAL_LINK_RETRANSMIT_TIME;
+        send_reliable(obj, id, dest, sender, now);
+    }
+    else if (sender->frame && !sender->acked && now - sender->sent_time >= sender->timeout) {
+        // Back off, so that a disconnected link doesn't get flooded
+        sender->timeout *= 2;
+        if (sender->timeout > SERIAL_LINK_RETRANSMIT_MAX_TIME) {
+            sender->timeout = SERIAL_LINK_RETRANSMIT_MAX_TIME;
+        }
+        send_reliable(obj, id, dest, sender, now);
+    }
+}
+
+// Acknowledges everything of the given type received from one side
+static void send_acks(uint8_t dest, remote_object_type object_type, uint8_t receiver_index) {
     unsigned int i;
     for(i=0;i<num_remote_objects;i++) {
         remote_object_t* obj = remote_objects[i];
-        if (obj->object_type == MASTER_TO_ALL_SLAVES || obj->object_type == SLAVE_TO_MASTER) {
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
-            uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-            if (ptr) {
-                ptr[obj->object_size] = i;
-                uint8_t dest = obj->object_type == MASTER_TO_ALL_SLAVES ? 0xFF : 0;
-                router_send_frame(dest, ptr, obj->object_size + 1);
+        if (obj->reliable && obj->object_type == object_type) {
+            reliable_receiver_t* receiver = &obj->reliable->receivers[receiver_index];
+            if (receiver->ack_pending) {
+                receiver->ack_pending = false;
+                uint8_t* record = add_record(dest, ACK_RECORD_SIZE);
+                record[0] = ACK_ID;
+                record[1] = i;
+                record[2] = receiver->seq;
             }
         }
-        else {
-            uint8_t* start = obj->buffer;
+    }
+}
+
+// Batches the objects of one type into frames to dest. Objects for a
+// single slave use the local buffer of that slave.
+static void send_objects(uint8_t dest, remote_object_type object_type, uint8_t slave, uint32_t now) {
+    unsigned int i;
+    for(i=0;i<num_remote_objects;i++) {
+        remote_object_t* obj = remote_objects[i];
+        if (obj->object_type != object_type) {
+            continue;
+        }
+        uint8_t* start = obj->buffer;
+        reliable_sender_t* sender = NULL;
+        if (object_type == MASTER_TO_SINGLE_SLAVE) {
+            start += slave * LOCAL_OBJECT_SIZE(obj->object_size);
+            sender = obj->reliable ? &obj->reliable->senders[slave] : NULL;
+        }
+        else if (obj->reliable && object_type == SLAVE_TO_MASTER) {
+            sender = &obj->reliable->senders[0];
+        }
+        send_object(obj, i, dest, (triple_buffer_object_t*)start, sender, now);
+    }
+}
+
+// Sends one frame for each destination with anything to send. The
+// router drops the frames going the wrong way, to the slaves on a slave
+// and to the master on the master. Destinations are a bit per slave,
+// see frame_router.c
+void update_transport(void) {
+    uint32_t now = serial_link_time();
+    send_objects(0xFF, MASTER_TO_ALL_SLAVES, 0, now);
+    flush_batch(0xFF);
+
+    // A slave acknowledges the master
+    send_objects(0, SLAVE_TO_MASTER, 0, now);
+    send_acks(0, MASTER_TO_SINGLE_SLAVE, 0);
+    flush_batch(0);
+
+    // The master acknowledges every slave
+    unsigned int i;
+    for (i=0;i<NUM_SLAVES;i++) {
+        send_objects(1 << i, MASTER_TO_SINGLE_SLAVE, i, now);
+        send_acks(1 << i, SLAVE_TO_MASTER, i);
+        flush_batch(1 << i);
+    }
+}
+
+bool transport_has_unacked(void) {
+    unsigned int i;
+    for(i=0;i<num_remote_objects;i++) {
+        remote_object_t* obj = remote_objects[i];
+        if (obj->reliable) {
             unsigned int j;
             for (j=0;j<NUM_SLAVES;j++) {
-                triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-                uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-                if (ptr) {
-                    ptr[obj->object_size] = i;
-                    uint8_t dest = j + 1;
-                    router_send_frame(dest, ptr, obj->object_size + 1);
+                reliable_sender_t* sender = &obj->reliable->senders[j];
+                if (sender->frame && !sender->acked) {
+                    return true;
                 }
-                start += LOCAL_OBJECT_SIZE(obj->object_size);
             }
         }
     }
+    return false;
 }
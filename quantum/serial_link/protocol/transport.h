@@ -27,9 +27,9 @@ SOFTWARE.
 
 #include "serial_link/protocol/triple_buffered_object.h"
 #include "serial_link/system/serial_link.h"
+#include <stddef.h>
 
 #define NUM_SLAVES 8
-#define LOCAL_OBJECT_EXTRA 16
 
 // master -> slave = 1 local(target all), 1 remote object
 // slave -> master = 1 local(target 0), multiple remote objects
@@ -40,37 +40,75 @@ typedef enum {
     SLAVE_TO_MASTER,
 } remote_object_type;
 
+// Reliable objects are sent again until the other side acknowledges
+// them, first after SERIAL_LINK_RETRANSMIT_TIME ms, then twice as long
+// every time up to SERIAL_LINK_RETRANSMIT_MAX_TIME ms
+#ifndef SERIAL_LINK_RETRANSMIT_TIME
+#define SERIAL_LINK_RETRANSMIT_TIME 10
+#endif
+#ifndef SERIAL_LINK_RETRANSMIT_MAX_TIME
+#define SERIAL_LINK_RETRANSMIT_MAX_TIME 160
+#endif
+
+typedef struct {
+    // The last frame sent, it stays in the read slot of the local
+    // triple buffer until the next write is read
+    uint8_t* frame;
+    uint32_t sent_time;
+    uint16_t timeout;
+    uint8_t seq;
+    bool acked;
+} reliable_sender_t;
+
+typedef struct {
+    uint8_t seq;
+    bool ack_pending;
+} reliable_receiver_t;
+
+// One sender and one receiver for each slave, only the ones for the
+// slave itself are used on the slaves
+typedef struct {
+    reliable_sender_t senders[NUM_SLAVES];
+    reliable_receiver_t receivers[NUM_SLAVES];
+} reliable_state_t;
+
 typedef struct {
     remote_object_type object_type;
     uint16_t object_size;
+    reliable_state_t* reliable;
     uint8_t buffer[] __attribute__((aligned(4)));
 } remote_object_t;
 
 #define REMOTE_OBJECT_SIZE(objectsize) \
     (sizeof(triple_buffer_object_t) + objectsize * 3)
 #define LOCAL_OBJECT_SIZE(objectsize) \
-    (sizeof(triple_buffer_object_t) + (objectsize + LOCAL_OBJECT_EXTRA) * 3)
+    (sizeof(triple_buffer_object_t) + objectsize * 3)
 
+// The same layout as remote_object_t, with room for the buffers. It
+// repeats the fields instead of holding a remote_object_t, since a
+// struct with a flexible array member can't be a member in C++.
 #define REMOTE_OBJECT_HELPER(name, type, num_local, num_remote) \
 typedef struct { \
-    remote_object_t object; \
+    remote_object_type object_type; \
+    uint16_t object_size; \
+    reliable_state_t* reliable; \
     uint8_t buffer[ \
         num_remote * REMOTE_OBJECT_SIZE(sizeof(type)) + \
-        num_local * LOCAL_OBJECT_SIZE(sizeof(type))]; \
-} remote_object_##name##_t;
+        num_local * LOCAL_OBJECT_SIZE(sizeof(type))] __attribute__((aligned(4))); \
+} remote_object_##name##_t; \
+typedef char remote_object_##name##_must_start_like_remote_object_t[ \
+    offsetof(remote_object_##name##_t, buffer) == offsetof(remote_object_t, buffer) ? 1 : -1];
 
 #define MASTER_TO_ALL_SLAVES_OBJECT(name, type) \
     REMOTE_OBJECT_HELPER(name, type, 1, 1) \
     remote_object_##name##_t remote_object_##name = { \
-        .object = { \
-            .object_type = MASTER_TO_ALL_SLAVES, \
-            .object_size = sizeof(type), \
-        } \
+        .object_type = MASTER_TO_ALL_SLAVES, \
+        .object_size = sizeof(type), \
     }; \
     type* begin_write_##name(void) { \
         remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
         triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer; \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)triple_buffer_begin_write_internal(sizeof(type), tb); \
     }\
     void end_write_##name(void) { \
         remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
@@ -85,20 +123,19 @@ typedef struct { \
         return (type*)triple_buffer_read_internal(obj->object_size, tb); \
     }
 
-#define MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
+#define MASTER_TO_SINGLE_SLAVE_OBJECT_HELPER(name, type, reliable_state) \
     REMOTE_OBJECT_HELPER(name, type, NUM_SLAVES, 1) \
     remote_object_##name##_t remote_object_##name = { \
-        .object = { \
-            .object_type = MASTER_TO_SINGLE_SLAVE, \
-            .object_size = sizeof(type), \
-        } \
+        .object_type = MASTER_TO_SINGLE_SLAVE, \
+        .object_size = sizeof(type), \
+        .reliable = reliable_state, \
     }; \
     type* begin_write_##name(uint8_t slave) { \
         remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
         uint8_t* start = obj->buffer;\
         start += slave * LOCAL_OBJECT_SIZE(obj->object_size); \
         triple_buffer_object_t* tb = (triple_buffer_object_t*)start; \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)triple_buffer_begin_write_internal(sizeof(type), tb); \
     }\
     void end_write_##name(uint8_t slave) { \
         remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
@@ -115,18 +152,17 @@ typedef struct { \
         return (type*)triple_buffer_read_internal(obj->object_size, tb); \
     }
 
-#define SLAVE_TO_MASTER_OBJECT(name, type) \
+#define SLAVE_TO_MASTER_OBJECT_HELPER(name, type, reliable_state) \
     REMOTE_OBJECT_HELPER(name, type, 1, NUM_SLAVES) \
     remote_object_##name##_t remote_object_##name = { \
-        .object = { \
-            .object_type = SLAVE_TO_MASTER, \
-            .object_size = sizeof(type), \
-        } \
+        .object_type = SLAVE_TO_MASTER, \
+        .object_size = sizeof(type), \
+        .reliable = reliable_state, \
     }; \
     type* begin_write_##name(void) { \
         remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
         triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer; \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)triple_buffer_begin_write_internal(sizeof(type), tb); \
     }\
     void end_write_##name(void) { \
         remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
@@ -142,11 +178,29 @@ typedef struct { \
         return (type*)triple_buffer_read_internal(obj->object_size, tb); \
     }
 
+#define MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
+    MASTER_TO_SINGLE_SLAVE_OBJECT_HELPER(name, type, NULL)
+
+#define SLAVE_TO_MASTER_OBJECT(name, type) \
+    SLAVE_TO_MASTER_OBJECT_HELPER(name, type, NULL)
+
+// The same objects, but acknowledged by the other side, and sent again
+// until they are
+#define RELIABLE_MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
+    static reliable_state_t reliable_state_##name; \
+    MASTER_TO_SINGLE_SLAVE_OBJECT_HELPER(name, type, &reliable_state_##name)
+
+#define RELIABLE_SLAVE_TO_MASTER_OBJECT(name, type) \
+    static reliable_state_t reliable_state_##name; \
+    SLAVE_TO_MASTER_OBJECT_HELPER(name, type, &reliable_state_##name)
+
 #define REMOTE_OBJECT(name) (remote_object_t*)&remote_object_##name
 
 void add_remote_objects(remote_object_t** remote_objects, uint32_t num_remote_objects);
 void reinitialize_serial_link_transport(void);
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size);
 void update_transport(void);
+// True while a reliable object is waiting for its acknowledgement
+bool transport_has_unacked(void);
 
 #endif
@@ -28,6 +28,7 @@ SOFTWARE.
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/frame_validator.h"
 #include "matrix.h"
 #include <stdbool.h>
 #include "print.h"
@@ -66,15 +67,19 @@ static SerialConfig config = {
 
 //#define DEBUG_LINK_ERRORS
 
+#ifndef SERIAL_LINK_READ_SIZE
+#define SERIAL_LINK_READ_SIZE 64
+#endif
+
+// Reads whatever the driver has received, in chunks, and hands each
+// chunk to the byte stuffer in one call.
 static uint32_t read_from_serial(SerialDriver* driver, uint8_t link) {
-    const uint32_t buffer_size = 16;
-    uint8_t buffer[buffer_size];
-    uint32_t bytes_read = sdAsynchronousRead(driver, buffer, buffer_size);
-    uint8_t* current = buffer;
-    uint8_t* end = current + bytes_read;
-    while(current < end) {
-        byte_stuffer_recv_byte(link, *current);
-        current++;
+    uint8_t buffer[SERIAL_LINK_READ_SIZE];
+    uint32_t bytes_read = 0;
+    size_t size;
+    while ((size = iqReadTimeout(&driver->iqueue, buffer, sizeof(buffer), TIME_IMMEDIATE)) > 0) {
+        byte_stuffer_recv(link, buffer, size);
+        bytes_read += size;
     }
     return bytes_read;
 }
@@ -137,7 +142,9 @@ static THD_FUNCTION(serialThread, arg) {
         eventflags_t flags1 = 0;
         eventflags_t flags2 = 0;
         if (need_wait) {
-            eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, MS2ST(1000));
+            // Wake up in time to send the unacknowledged objects again
+            systime_t timeout = transport_has_unacked() ? MS2ST(SERIAL_LINK_RETRANSMIT_TIME) : MS2ST(1000);
+            eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, timeout);
             if (mask & EVENT_MASK(1)) {
                 flags1 = chEvtGetAndClearFlags(&sd1_listener);
                 print_error("DOWNLINK", flags1, &SD1);
@@ -176,7 +183,7 @@ typedef struct {
 
 static matrix_object_t last_matrix = {};
 
-SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_object_t);
+RELIABLE_SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_object_t);
 MASTER_TO_ALL_SLAVES_OBJECT(serial_link_connected, bool);
 
 static remote_object_t* remote_objects[] = {
@@ -184,8 +191,32 @@ static remote_object_t* remote_objects[] = {
     REMOTE_OBJECT(keyboard_matrix),
 };
 
+#ifdef SERIAL_LINK_CRC_HARDWARE
+
+#ifndef CRC_CR_REV_IN
+#error "SERIAL_LINK_CRC_HARDWARE needs a CRC unit that can reverse the bits, like the one of the STM32F0, F3 and F7"
+#endif
+
+// Only the serial link thread sends and validates frames, so the CRC unit
+// doesn't need a lock
+uint32_t serial_link_crc32_hardware(const uint8_t* data, uint32_t size) {
+    CRC->INIT = 0xFFFFFFFF;
+    // Reverse the bits of every byte and of the result, like the
+    // software CRC does
+    CRC->CR = CRC_CR_REV_IN_0 | CRC_CR_REV_OUT | CRC_CR_RESET;
+    while (size--) {
+        *(volatile uint8_t*)&CRC->DR = *data++;
+    }
+    return ~CRC->DR;
+}
+
+#endif
+
 void init_serial_link(void) {
     serial_link_connected = false;
+#ifdef SERIAL_LINK_CRC_HARDWARE
+    rccEnableCRC(false);
+#endif
     init_serial_link_hal();
     add_remote_objects(remote_objects, sizeof(remote_objects)/sizeof(remote_object_t*));
     init_byte_stuffer();
@@ -234,6 +265,10 @@ void signal_data_written(void) {
     chEvtBroadcast(&new_data_event);
 }
 
+uint32_t serial_link_time(void) {
+    return ST2MS(chVTGetSystemTimeX());
+}
+
 bool is_serial_link_connected(void) {
     return serial_link_connected;
 }
@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include "host_driver.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 void init_serial_link(void);
 void init_serial_link_hal(void);
@@ -47,6 +48,18 @@ static inline void serial_link_unlock(void) {
 }
 
 void signal_data_written(void);
+// Milliseconds since the start, for the retransmit timers
+uint32_t serial_link_time(void);
+
+#elif defined(SERIAL_LINK_THREADED)
+
+// Host builds that share objects between threads provide a real lock
+void serial_link_lock(void);
+void serial_link_unlock(void);
+
+void signal_data_written(void);
+// Milliseconds since the start, for the retransmit timers
+uint32_t serial_link_time(void);
 
 #else
 
@@ -57,6 +70,8 @@ inline void serial_link_unlock(void) {
 }
 
 void signal_data_written(void);
+// Milliseconds since the start, for the retransmit timers
+uint32_t serial_link_time(void);
 
 #endif
 
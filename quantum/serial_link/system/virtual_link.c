@@ -0,0 +1,208 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "serial_link/system/virtual_link.h"
+#include "serial_link/system/serial_link.h"
+#include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/physical.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define MAX_NODES 9
+
+static uint8_t node;
+static uint8_t nodes;
+static int link_fds[NUM_LINKS] = {-1, -1};
+static pid_t children[MAX_NODES];
+static virtual_link_config_t config;
+static virtual_link_stats_t stats;
+static unsigned int random_state;
+
+uint8_t virtual_link_start(uint8_t num_nodes, const virtual_link_config_t* _config) {
+    int pairs[MAX_NODES - 1][2];
+    uint8_t i;
+
+    if (num_nodes < 1 || num_nodes > MAX_NODES) {
+        abort();
+    }
+    nodes = num_nodes;
+    config = *_config;
+    memset(&stats, 0, sizeof(stats));
+    for (i=0;i + 1<nodes;i++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[i]) != 0) {
+            abort();
+        }
+    }
+
+    node = 0;
+    for (i=1;i<nodes;i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            abort();
+        }
+        if (pid == 0) {
+            node = i;
+            break;
+        }
+        children[i] = pid;
+    }
+
+    // Keep the two ends this node uses and close all the others
+    for (i=0;i + 1<nodes;i++) {
+        if (i == node) {
+            link_fds[DOWN_LINK] = pairs[i][0];
+        }
+        else {
+            close(pairs[i][0]);
+        }
+        if (i + 1 == node) {
+            link_fds[UP_LINK] = pairs[i][1];
+        }
+        else {
+            close(pairs[i][1]);
+        }
+    }
+
+    random_state = node + 1;
+    init_byte_stuffer();
+    router_set_master(node == 0);
+    return node;
+}
+
+bool virtual_link_poll(uint32_t timeout_ms) {
+    struct pollfd fds[NUM_LINKS];
+    uint8_t links[NUM_LINKS];
+    nfds_t num_fds = 0;
+    uint8_t link;
+    for (link=0;link<NUM_LINKS;link++) {
+        if (link_fds[link] >= 0) {
+            fds[num_fds].fd = link_fds[link];
+            fds[num_fds].events = POLLIN;
+            links[num_fds] = link;
+            num_fds++;
+        }
+    }
+
+    if (poll(fds, num_fds, timeout_ms) < 0) {
+        return errno == EINTR;
+    }
+
+    bool up_link_open = true;
+    nfds_t i;
+    for (i=0;i<num_fds;i++) {
+        if (fds[i].revents & (POLLIN | POLLHUP)) {
+            uint8_t buffer[256];
+            ssize_t size = read(fds[i].fd, buffer, sizeof(buffer));
+            if (size > 0) {
+                stats.bytes_received += size;
+                byte_stuffer_recv(links[i], buffer, size);
+            }
+            else if (links[i] == UP_LINK) {
+                up_link_open = false;
+            }
+        }
+    }
+    return up_link_open;
+}
+
+void virtual_link_stop(void) {
+    uint8_t link;
+    for (link=0;link<NUM_LINKS;link++) {
+        if (link_fds[link] >= 0) {
+            close(link_fds[link]);
+            link_fds[link] = -1;
+        }
+    }
+    if (node == 0) {
+        uint8_t i;
+        for (i=1;i<nodes;i++) {
+            waitpid(children[i], NULL, 0);
+        }
+    }
+    else {
+        _exit(0);
+    }
+}
+
+const virtual_link_stats_t* virtual_link_stats(void) {
+    return &stats;
+}
+
+uint64_t virtual_link_time_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+    uint8_t buffer[size];
+    uint16_t out = 0;
+    uint16_t i;
+    if (link_fds[link] < 0) {
+        return;
+    }
+    for (i=0;i<size;i++) {
+        uint8_t byte = data[i];
+        if (config.drop_one_in && rand_r(&random_state) % config.drop_one_in == 0) {
+            stats.bytes_dropped++;
+            continue;
+        }
+        if (config.corrupt_one_in && rand_r(&random_state) % config.corrupt_one_in == 0) {
+            byte ^= 1 << (rand_r(&random_state) % 8);
+            stats.bytes_corrupted++;
+        }
+        buffer[out++] = byte;
+    }
+    // A full socket buffer loses the rest of the bytes, like an overrun
+    // UART would, and they are counted
+    uint16_t written = 0;
+    while (written < out) {
+        ssize_t result = send(link_fds[link], buffer + written, out - written, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (result > 0) {
+            written += result;
+        }
+        else if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            break;
+        }
+    }
+    stats.bytes_sent += written;
+    stats.bytes_overrun += out - written;
+}
+
+uint32_t serial_link_time(void) {
+    return virtual_link_time_us() / 1000;
+}
+
+void signal_data_written(void) {
+}
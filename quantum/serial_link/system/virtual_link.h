@@ -0,0 +1,67 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_VIRTUAL_LINK_H
+#define SERIAL_LINK_VIRTUAL_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A serial link between processes on the host, so that the whole
+// protocol stack can run without hardware. Every node is a process of
+// its own, since the protocol layers keep their state in globals. Node 0
+// is the master, and the down link of every node is connected to the up
+// link of the next one, like a chain of keyboard halves.
+
+typedef struct {
+    // Flip a random bit in one of this many bytes sent, 0 for never
+    uint32_t corrupt_one_in;
+    // Drop one of this many bytes sent, 0 for never
+    uint32_t drop_one_in;
+} virtual_link_config_t;
+
+typedef struct {
+    uint32_t bytes_sent;
+    uint32_t bytes_received;
+    uint32_t bytes_corrupted;
+    uint32_t bytes_dropped;
+    // Bytes lost because the socket buffer was full
+    uint32_t bytes_overrun;
+} virtual_link_stats_t;
+
+// Forks num_nodes - 1 processes, connects them and initializes the
+// protocol stack in each. Returns the node number of the calling
+// process, 0 in the original one.
+uint8_t virtual_link_start(uint8_t num_nodes, const virtual_link_config_t* config);
+// Feeds the bytes that arrived to the byte stuffer, after waiting up to
+// timeout_ms for them. Returns false once the up link is closed, which
+// tells a slave to stop.
+bool virtual_link_poll(uint32_t timeout_ms);
+// Closes the links. The master waits for the slaves to exit, the slaves
+// exit.
+void virtual_link_stop(void);
+const virtual_link_stats_t* virtual_link_stats(void);
+uint64_t virtual_link_time_us(void);
+
+#endif
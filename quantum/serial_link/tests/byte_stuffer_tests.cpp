@@ -481,3 +481,50 @@ TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_254_bytes_and_then_zero) {
        byte_stuffer_recv_byte(1, d);
     }
 }
+
+TEST_F(ByteStuffer, receives_a_roundtrip_in_a_single_chunk) {
+    uint8_t original_data[600];
+    int i;
+    for(i=0;i<600;i++) {
+        original_data[i] = i % 7 == 0 ? 0 : i;
+    }
+    byte_stuffer_send_frame(0, original_data, sizeof(original_data));
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(original_data)));
+    byte_stuffer_recv(1, sent_data.data(), sent_data.size());
+}
+
+TEST_F(ByteStuffer, receives_two_frames_split_over_chunks) {
+    uint8_t expected1[] = {5, 0, 3};
+    uint8_t expected2[] = {0x37, 0x99, 0xFF};
+    uint8_t data[] = {2, 5, 2, 3, 0, 4, 0x37, 0x99, 0xFF, 0};
+    testing::Sequence s;
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(expected1)))
+        .InSequence(s);
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(expected2)))
+        .InSequence(s);
+    byte_stuffer_recv(0, data, 3);
+    byte_stuffer_recv(0, data + 3, 4);
+    byte_stuffer_recv(0, data + 7, 3);
+}
+
+TEST_F(ByteStuffer, receives_a_valid_frame_after_an_invalid_one_in_the_same_chunk) {
+    uint8_t expected[] = {0x37};
+    uint8_t data[] = {4, 0x11, 0, 2, 0x37, 0};
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(expected)));
+    byte_stuffer_recv(0, data, sizeof(data));
+}
+
+TEST_F(ByteStuffer, receives_no_frame_when_a_chunk_exceeds_the_max_frame_size) {
+    uint8_t data[MAX_FRAME_SIZE * 2];
+    int i;
+    for(i=0;i<MAX_FRAME_SIZE * 2;i++) {
+        data[i] = i % 0xFF == 0 ? 0xFF : 1;
+    }
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .Times(0);
+    byte_stuffer_recv(0, data, sizeof(data));
+}
@@ -0,0 +1,125 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+extern "C" {
+#include "serial_link/protocol/frame_validator.h"
+}
+
+// Frame rate of validator_send_frame and validator_recv_frame, against
+// the byte at a time CRC the validator used before
+
+static uint32_t frames_received;
+static uint32_t last_sent_crc;
+
+extern "C" {
+void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) {
+    frames_received++;
+}
+
+void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
+    memcpy(&last_sent_crc, data + size - 4, 4);
+}
+}
+
+static uint32_t byte_table[256];
+
+static void init_byte_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        byte_table[i] = crc;
+    }
+}
+
+static uint32_t crc32_byte(const uint8_t* p, uint32_t size) {
+    uint32_t crc = 0xffffffff;
+    while (size-- != 0) crc = byte_table[((uint8_t) crc ^ *(p++))] ^ (crc >> 8);
+    return crc ^ 0xffffffff;
+}
+
+class FrameValidatorBenchmark : public testing::Test {
+public:
+    FrameValidatorBenchmark() {
+        init_byte_table();
+        frames_received = 0;
+        std::mt19937 random(1);
+        for (auto& d : data) {
+            d = random();
+        }
+    }
+
+    template<typename F>
+    double frames_per_second(F frame, uint32_t num_frames) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < num_frames; i++) {
+            frame(i);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return num_frames / elapsed.count();
+    }
+
+    uint8_t data[1024 + 4];
+};
+
+TEST_F(FrameValidatorBenchmark, computes_the_same_crc_as_byte_at_a_time) {
+    for (uint16_t size = 1; size < 64; size++) {
+        validator_send_frame(0, data, size);
+        EXPECT_EQ(last_sent_crc, crc32_byte(data, size)) << "size " << size;
+        validator_recv_frame(0, data, size + 4);
+    }
+    EXPECT_EQ(frames_received, 63);
+}
+
+TEST_F(FrameValidatorBenchmark, frame_rate) {
+    const uint16_t sizes[] = {8, 32, 128, 1024};
+    for (uint16_t size : sizes) {
+        uint32_t num_frames = 4 * 1024 * 1024 / size;
+        volatile uint32_t sink = 0;
+        double before = frames_per_second([&](uint32_t i) {
+            // what validator_send_frame and validator_recv_frame did
+            data[0] = i;
+            uint32_t crc = crc32_byte(data, size);
+            memcpy(data + size, &crc, 4);
+            uint32_t frame_crc;
+            memcpy(&frame_crc, data + size, 4);
+            sink += frame_crc == crc32_byte(data, size);
+        }, num_frames);
+        frames_received = 0;
+        double after = frames_per_second([&](uint32_t i) {
+            data[0] = i;
+            validator_send_frame(0, data, size);
+            validator_recv_frame(0, data, size + 4);
+        }, num_frames);
+        EXPECT_EQ(frames_received, num_frames);
+        printf("%4u byte frames: %10.0f/s byte at a time, %10.0f/s now, %.1fx\n",
+            size, before, after, after / before);
+    }
+}
@@ -0,0 +1,123 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+extern "C" {
+#include "serial_link/protocol/frame_validator.h"
+}
+
+// Built with SERIAL_LINK_CRC16_MAX_SIZE 16
+
+using testing::_;
+using testing::ElementsAreArray;
+using testing::Args;
+
+class FrameValidatorCrc16 : public testing::Test {
+public:
+    FrameValidatorCrc16() {
+        Instance = this;
+    }
+
+    ~FrameValidatorCrc16() {
+        Instance = nullptr;
+    }
+
+    MOCK_METHOD3(route_incoming_frame, void (uint8_t link, uint8_t* data, uint16_t size));
+    MOCK_METHOD3(byte_stuffer_send_frame, void (uint8_t link, uint8_t* data, uint16_t size));
+
+    static FrameValidatorCrc16* Instance;
+};
+
+FrameValidatorCrc16* FrameValidatorCrc16::Instance = nullptr;
+
+extern "C" {
+void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) {
+    FrameValidatorCrc16::Instance->route_incoming_frame(link, data, size);
+}
+
+void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
+    FrameValidatorCrc16::Instance->byte_stuffer_send_frame(link, data, size);
+}
+}
+
+TEST_F(FrameValidatorCrc16, sends_small_frame_with_16_bit_crc) {
+    uint8_t original[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9', 0, 0, 0, 0};
+    uint8_t expected[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9', 0xB1, 0x29};
+    EXPECT_CALL(*this, byte_stuffer_send_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(expected)));
+    validator_send_frame(0, original, 9);
+}
+
+TEST_F(FrameValidatorCrc16, validates_small_frame_with_16_bit_crc) {
+    uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9', 0xB1, 0x29};
+    EXPECT_CALL(*this, route_incoming_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(data, 9)));
+    validator_recv_frame(0, data, 11);
+}
+
+TEST_F(FrameValidatorCrc16, does_not_validate_small_frame_with_incorrect_crc) {
+    uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9', 0xB1, 0x28};
+    EXPECT_CALL(*this, route_incoming_frame(_, _, _))
+        .Times(0);
+    validator_recv_frame(0, data, 11);
+}
+
+TEST_F(FrameValidatorCrc16, sends_bigger_frame_with_32_bit_crc) {
+    uint8_t data[17 + 4] = {};
+    std::vector<uint8_t> sent;
+    EXPECT_CALL(*this, byte_stuffer_send_frame(_, _, 21))
+        .WillOnce(testing::Invoke([&](uint8_t link, uint8_t* frame, uint16_t size) {
+            sent.assign(frame, frame + size);
+        }));
+    validator_send_frame(0, data, 17);
+    EXPECT_CALL(*this, route_incoming_frame(_, _, 17));
+    validator_recv_frame(0, sent.data(), sent.size());
+}
+
+TEST_F(FrameValidatorCrc16, frames_of_every_size_go_through) {
+    for (uint16_t size = 1; size < 40; size++) {
+        uint8_t data[40 + 4];
+        for (uint16_t i = 0; i < size; i++) {
+            data[i] = i * 7 + size;
+        }
+        std::vector<uint8_t> sent;
+        EXPECT_CALL(*this, byte_stuffer_send_frame(_, _, _))
+            .WillOnce(testing::Invoke([&](uint8_t link, uint8_t* frame, uint16_t frame_size) {
+                sent.assign(frame, frame + frame_size);
+            }));
+        validator_send_frame(0, data, size);
+        EXPECT_CALL(*this, route_incoming_frame(_, _, size));
+        validator_recv_frame(0, sent.data(), sent.size());
+        testing::Mock::VerifyAndClearExpectations(this);
+    }
+}
+
+TEST_F(FrameValidatorCrc16, ignores_sizes_between_the_two_crcs) {
+    uint8_t data[20] = {};
+    EXPECT_CALL(*this, route_incoming_frame(_, _, _))
+        .Times(0);
+    validator_recv_frame(0, data, 19);
+    validator_recv_frame(0, data, 20);
+}
@@ -6,6 +6,16 @@ serial_link_frame_validator_SRC := \
 	$(SERIAL_PATH)/tests/frame_validator_tests.cpp \
 	$(SERIAL_PATH)/protocol/frame_validator.c 
 
+serial_link_frame_validator_crc16_SRC := \
+	$(SERIAL_PATH)/tests/frame_validator_crc16_tests.cpp \
+	$(SERIAL_PATH)/protocol/frame_validator.c
+
+serial_link_frame_validator_crc16_DEFS := -DSERIAL_LINK_CRC16_MAX_SIZE=16
+
+serial_link_frame_validator_benchmark_SRC := \
+	$(SERIAL_PATH)/tests/frame_validator_benchmark_tests.cpp \
+	$(SERIAL_PATH)/protocol/frame_validator.c
+
 serial_link_frame_router_SRC := \
 	$(SERIAL_PATH)/tests/frame_router_tests.cpp \
 	$(SERIAL_PATH)/protocol/byte_stuffer.c \
@@ -20,3 +30,19 @@ serial_link_transport_SRC := \
 	$(SERIAL_PATH)/tests/transport_tests.cpp \
 	$(SERIAL_PATH)/protocol/transport.c \
 	$(SERIAL_PATH)/protocol/triple_buffered_object.c 
+
+serial_link_virtual_link_SRC := \
+	$(SERIAL_PATH)/tests/virtual_link_tests.cpp \
+	$(SERIAL_PATH)/tests/virtual_link_objects.c \
+	$(SERIAL_PATH)/system/virtual_link.c \
+	$(SERIAL_PATH)/protocol/byte_stuffer.c \
+	$(SERIAL_PATH)/protocol/frame_validator.c \
+	$(SERIAL_PATH)/protocol/frame_router.c \
+	$(SERIAL_PATH)/protocol/transport.c \
+	$(SERIAL_PATH)/protocol/triple_buffered_object.c
+
+serial_link_triple_buffered_object_stress_SRC := \
+	$(SERIAL_PATH)/tests/triple_buffered_object_stress_tests.cpp \
+	$(SERIAL_PATH)/protocol/triple_buffered_object.c
+
+serial_link_triple_buffered_object_stress_DEFS := -DSERIAL_LINK_THREADED
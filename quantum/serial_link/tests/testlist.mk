@@ -1,6 +1,10 @@
 TEST_LIST +=\
 	serial_link_byte_stuffer\
 	serial_link_frame_validator\
+	serial_link_frame_validator_crc16\
+	serial_link_frame_validator_benchmark\
 	serial_link_frame_router\
 	serial_link_triple_buffered_object\
-	serial_link_transport
\ No newline at end of file
+	serial_link_triple_buffered_object_stress\
+	serial_link_transport\
+	serial_link_virtual_link
@@ -45,11 +45,13 @@ struct test_object2 {
 MASTER_TO_ALL_SLAVES_OBJECT(master_to_slave, test_object1);
 MASTER_TO_SINGLE_SLAVE_OBJECT(master_to_single_slave, test_object1);
 SLAVE_TO_MASTER_OBJECT(slave_to_master, test_object1);
+RELIABLE_SLAVE_TO_MASTER_OBJECT(reliable_slave_to_master, test_object1);
 
 static remote_object_t* test_remote_objects[] = {
     REMOTE_OBJECT(master_to_slave),
     REMOTE_OBJECT(master_to_single_slave),
     REMOTE_OBJECT(slave_to_master),
+    REMOTE_OBJECT(reliable_slave_to_master),
 };
 
 class Transport : public testing::Test {
@@ -75,6 +77,7 @@ public:
     static Transport* Instance;
 
     std::vector<uint8_t> sent_data;
+    uint32_t time = 0;
 };
 
 Transport* Transport::Instance = nullptr;
@@ -87,6 +90,10 @@ void signal_data_written(void) {
 void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
     Transport::Instance->router_send_frame(destination, data, size);
 }
+
+uint32_t serial_link_time(void) {
+    return Transport::Instance->time;
+}
 }
 
 TEST_F(Transport, write_to_local_signals_an_event) {
@@ -136,7 +143,7 @@ TEST_F(Transport, writes_from_master_to_single_slave) {
     obj->test = 7;
     EXPECT_CALL(*this, signal_data_written());
     end_write_master_to_single_slave(3);
-    EXPECT_CALL(*this, router_send_frame(4));
+    EXPECT_CALL(*this, router_send_frame(8));
     update_transport();
     transport_recv_frame(0, sent_data.data(), sent_data.size());
     test_object1* obj2 = read_master_to_single_slave();
@@ -150,9 +157,9 @@ TEST_F(Transport, ignores_object_with_invalid_id) {
     obj->test = 7;
     EXPECT_CALL(*this, signal_data_written());
     end_write_master_to_single_slave(3);
-    EXPECT_CALL(*this, router_send_frame(4));
+    EXPECT_CALL(*this, router_send_frame(8));
     update_transport();
-    sent_data[sent_data.size() - 1] = 44;
+    sent_data[0] = 44;
     transport_recv_frame(0, sent_data.data(), sent_data.size());
     test_object1* obj2 = read_master_to_single_slave();
     EXPECT_EQ(obj2, nullptr);
@@ -166,7 +173,6 @@ TEST_F(Transport, ignores_object_with_size_too_small) {
     end_write_master_to_slave();
     EXPECT_CALL(*this, router_send_frame(_));
     update_transport();
-    sent_data[sent_data.size() - 2] = 0;
     transport_recv_frame(0, sent_data.data(), sent_data.size() - 1);
     test_object1* obj2 = read_master_to_slave();
     EXPECT_EQ(obj2, nullptr);
@@ -180,9 +186,73 @@ TEST_F(Transport, ignores_object_with_size_too_big) {
     end_write_master_to_slave();
     EXPECT_CALL(*this, router_send_frame(_));
     update_transport();
-    sent_data.resize(sent_data.size() + 22);
-    sent_data[sent_data.size() - 1] = 0;
+    sent_data.resize(sent_data.size() + 1);
     transport_recv_frame(0, sent_data.data(), sent_data.size());
     test_object1* obj2 = read_master_to_slave();
     EXPECT_EQ(obj2, nullptr);
 }
+
+TEST_F(Transport, sends_objects_for_the_same_destination_in_one_frame) {
+    update_transport();
+    begin_write_slave_to_master()->test = 7;
+    EXPECT_CALL(*this, signal_data_written()).Times(2);
+    end_write_slave_to_master();
+    begin_write_reliable_slave_to_master()->test = 8;
+    end_write_reliable_slave_to_master();
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    test_object1* obj = read_slave_to_master(0);
+    EXPECT_NE(obj, nullptr);
+    EXPECT_EQ(obj->test, 7);
+    obj = read_reliable_slave_to_master(0);
+    EXPECT_NE(obj, nullptr);
+    EXPECT_EQ(obj->test, 8);
+}
+
+TEST_F(Transport, sends_reliable_object_again_until_acknowledged) {
+    update_transport();
+    test_object1* obj = begin_write_reliable_slave_to_master();
+    obj->test = 7;
+    EXPECT_CALL(*this, signal_data_written());
+    end_write_reliable_slave_to_master();
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    std::vector<uint8_t> frame = sent_data;
+    EXPECT_TRUE(transport_has_unacked());
+    time += SERIAL_LINK_RETRANSMIT_TIME - 1;
+    EXPECT_CALL(*this, router_send_frame(_)).Times(0);
+    update_transport();
+    time += 1;
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+
+    transport_recv_frame(1, frame.data(), frame.size());
+    test_object1* obj2 = read_reliable_slave_to_master(0);
+    EXPECT_NE(obj2, nullptr);
+    EXPECT_EQ(obj2->test, 7);
+
+    sent_data.clear();
+    EXPECT_CALL(*this, router_send_frame(1));
+    update_transport();
+    transport_recv_frame(0, sent_data.data(), sent_data.size());
+    EXPECT_FALSE(transport_has_unacked());
+    time += SERIAL_LINK_RETRANSMIT_MAX_TIME;
+    EXPECT_CALL(*this, router_send_frame(_)).Times(0);
+    update_transport();
+}
+
+TEST_F(Transport, backs_off_when_reliable_object_is_not_acknowledged) {
+    update_transport();
+    begin_write_reliable_slave_to_master()->test = 3;
+    EXPECT_CALL(*this, signal_data_written());
+    end_write_reliable_slave_to_master();
+    EXPECT_CALL(*this, router_send_frame(0)).Times(3);
+    update_transport();
+    time += SERIAL_LINK_RETRANSMIT_TIME;
+    update_transport();
+    time += SERIAL_LINK_RETRANSMIT_TIME;
+    update_transport();
+    time += SERIAL_LINK_RETRANSMIT_TIME;
+    update_transport();
+}
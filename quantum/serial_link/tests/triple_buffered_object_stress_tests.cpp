@@ -0,0 +1,179 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdio>
+#include <thread>
+#include <vector>
+extern "C" {
+#include "serial_link/protocol/triple_buffered_object.h"
+#include "serial_link/system/serial_link.h"
+}
+
+// Writer and reader threads hammering triple buffered objects, the way
+// the serial link thread and the main loop share them on ChibiOS. Every
+// object is filled with its sequence number, so a reader that gets a
+// buffer the writer is still filling sees a mix of them. Races only
+// show up when the threads really run at the same time, on more than
+// one core.
+
+#define RUN_TIME std::chrono::milliseconds(300)
+#define OBJECT_WORDS 16
+
+// chSysLock on the keyboard, a spin lock here
+static std::atomic_flag lock = ATOMIC_FLAG_INIT;
+static std::atomic<uint64_t> lock_spins;
+
+extern "C" {
+void serial_link_lock(void) {
+    while (lock.test_and_set(std::memory_order_acquire)) {
+        lock_spins.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+}
+
+void serial_link_unlock(void) {
+    lock.clear(std::memory_order_release);
+}
+}
+
+struct stress_object {
+    uint8_t state;
+    struct {
+        uint32_t words[OBJECT_WORDS];
+    } buffer[3];
+};
+
+struct PairResult {
+    uint64_t writes = 0;
+    uint64_t reads = 0;
+    uint64_t new_objects = 0;
+    uint64_t torn = 0;
+    uint64_t out_of_order = 0;
+    uint32_t last_written = 0;
+    uint32_t last_read = 0;
+};
+
+static void writer(stress_object& object, std::atomic<bool>* running, PairResult* result) {
+    uint32_t seq = 0;
+    while (running->load(std::memory_order_relaxed)) {
+        seq++;
+        volatile uint32_t* words = (triple_buffer_begin_write(&object))->words;
+        for (int i = 0; i < OBJECT_WORDS; i++) {
+            words[i] = seq;
+        }
+        triple_buffer_end_write(&object);
+    }
+    result->writes = seq;
+    result->last_written = seq;
+}
+
+static void reader(stress_object& object, std::atomic<bool>* running, PairResult* result) {
+    auto check = [&]() {
+        result->reads++;
+        auto* read = triple_buffer_read(&object);
+        if (!read) {
+            return;
+        }
+        volatile uint32_t* words = read->words;
+        uint32_t seq = words[0];
+        for (int i = 1; i < OBJECT_WORDS; i++) {
+            if (words[i] != seq) {
+                result->torn++;
+                return;
+            }
+        }
+        if (seq <= result->last_read) {
+            result->out_of_order++;
+        }
+        result->last_read = seq;
+        result->new_objects++;
+    };
+    while (running->load(std::memory_order_relaxed)) {
+        check();
+    }
+    // pick up whatever the writer finished with
+    check();
+}
+
+static std::vector<PairResult> run_pairs(unsigned num_pairs) {
+    std::vector<stress_object> objects(num_pairs);
+    std::vector<PairResult> results(num_pairs);
+    std::atomic<bool> writing(true);
+    std::atomic<bool> reading(true);
+    std::vector<std::thread> writers;
+    std::vector<std::thread> readers;
+    lock_spins = 0;
+
+    for (unsigned i = 0; i < num_pairs; i++) {
+        triple_buffer_init((triple_buffer_object_t*)&objects[i]);
+        writers.emplace_back(writer, std::ref(objects[i]), &writing, &results[i]);
+        readers.emplace_back(reader, std::ref(objects[i]), &reading, &results[i]);
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(RUN_TIME);
+    writing = false;
+    for (auto& t : writers) {
+        t.join();
+    }
+    reading = false;
+    for (auto& t : readers) {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    PairResult total;
+    for (auto& r : results) {
+        total.writes += r.writes;
+        total.reads += r.reads;
+        total.new_objects += r.new_objects;
+        total.torn += r.torn;
+    }
+    printf("%u pairs: %10.0f writes/s, %10.0f reads/s, %8.0f new objects/s, %llu lock spins, %llu torn\n",
+        num_pairs, total.writes / elapsed.count(), total.reads / elapsed.count(),
+        total.new_objects / elapsed.count(),
+        (unsigned long long)lock_spins.load(), (unsigned long long)total.torn);
+    return results;
+}
+
+static void expect_consistent(const std::vector<PairResult>& results) {
+    for (auto& r : results) {
+        EXPECT_GT(r.writes, 0u);
+        EXPECT_GT(r.new_objects, 0u);
+        EXPECT_EQ(r.torn, 0u);
+        EXPECT_EQ(r.out_of_order, 0u);
+        EXPECT_EQ(r.last_read, r.last_written);
+    }
+}
+
+TEST(TripleBufferedObjectStress, reader_never_sees_a_torn_object) {
+    expect_consistent(run_pairs(1));
+}
+
+TEST(TripleBufferedObjectStress, pairs_of_threads_share_the_lock) {
+    expect_consistent(run_pairs(4));
+}
@@ -0,0 +1,43 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "serial_link/protocol/transport.h"
+#include "virtual_link_objects.h"
+
+MASTER_TO_ALL_SLAVES_OBJECT(ping, ping_object_t);
+SLAVE_TO_MASTER_OBJECT(pong, ping_object_t);
+RELIABLE_MASTER_TO_SINGLE_SLAVE_OBJECT(slave_config, state_object_t);
+RELIABLE_SLAVE_TO_MASTER_OBJECT(slave_state, state_object_t);
+
+static remote_object_t* virtual_link_objects[] = {
+    REMOTE_OBJECT(ping),
+    REMOTE_OBJECT(pong),
+    REMOTE_OBJECT(slave_config),
+    REMOTE_OBJECT(slave_state),
+};
+
+void add_virtual_link_objects(void) {
+    reinitialize_serial_link_transport();
+    add_remote_objects(virtual_link_objects, sizeof(virtual_link_objects) / sizeof(remote_object_t*));
+}
@@ -0,0 +1,61 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_VIRTUAL_LINK_OBJECTS_H
+#define SERIAL_LINK_VIRTUAL_LINK_OBJECTS_H
+
+#include <stdint.h>
+
+// The remote objects of the virtual link tests, the object macros can
+// only be used from C
+
+typedef struct {
+    uint32_t seq;
+    uint32_t check;
+    uint64_t time;
+} ping_object_t;
+
+typedef struct {
+    uint32_t value;
+} state_object_t;
+
+void add_virtual_link_objects(void);
+
+ping_object_t* begin_write_ping(void);
+void end_write_ping(void);
+ping_object_t* read_ping(void);
+
+ping_object_t* begin_write_pong(void);
+void end_write_pong(void);
+ping_object_t* read_pong(uint8_t slave);
+
+state_object_t* begin_write_slave_config(uint8_t slave);
+void end_write_slave_config(uint8_t slave);
+state_object_t* read_slave_config(void);
+
+state_object_t* begin_write_slave_state(void);
+void end_write_slave_state(void);
+state_object_t* read_slave_state(uint8_t slave);
+
+#endif
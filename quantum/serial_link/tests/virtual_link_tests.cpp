@@ -0,0 +1,170 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2026 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <algorithm>
+extern "C" {
+#include "serial_link/system/virtual_link.h"
+#include "serial_link/protocol/transport.h"
+#include "virtual_link_objects.h"
+}
+
+// Runs the whole protocol stack on a master and its slaves, each in a
+// process of its own. The master sends pings to all the slaves, and they
+// answer with pongs. Every slave also echoes back the config the master
+// sent to it alone, both ways reliably.
+
+// Only one ping is in flight at a time, so a clean link can't lose
+// one, and the timeout only has to catch a broken link. On a lossy link
+// a lost ping waits for the timeout, so it is kept short there.
+#define CLEAN_LINK_TIMEOUT_US 1000000
+#define LOSSY_LINK_TIMEOUT_US 20000
+
+struct LinkResult {
+    uint32_t pings = 0;
+    uint32_t pongs = 0;
+    uint32_t bad_pongs = 0;
+    uint64_t total_latency_us = 0;
+    uint64_t max_latency_us = 0;
+    uint64_t duration_us = 0;
+    bool states_received = false;
+    uint32_t bytes_overrun = 0;
+};
+
+static void run_slave(void) {
+    while (virtual_link_poll(10)) {
+        ping_object_t* ping = read_ping();
+        if (ping) {
+            *begin_write_pong() = *ping;
+            end_write_pong();
+        }
+        state_object_t* config = read_slave_config();
+        if (config) {
+            *begin_write_slave_state() = *config;
+            end_write_slave_state();
+        }
+        update_transport();
+    }
+    virtual_link_stop();
+}
+
+static LinkResult run_link(uint8_t num_nodes, virtual_link_config_t config, uint32_t num_pings,
+                           uint64_t timeout_us) {
+    add_virtual_link_objects();
+    uint8_t node = virtual_link_start(num_nodes, &config);
+    if (node != 0) {
+        run_slave();
+    }
+
+    uint8_t num_slaves = num_nodes - 1;
+    for (uint8_t slave = 0; slave < num_slaves; slave++) {
+        begin_write_slave_config(slave)->value = (slave + 1) * 1000;
+        end_write_slave_config(slave);
+    }
+    uint32_t states_seen = 0;
+    LinkResult result;
+    uint64_t start = virtual_link_time_us();
+    for (uint32_t seq = 1; seq <= num_pings; seq++) {
+        uint64_t sent = virtual_link_time_us();
+        ping_object_t* ping = begin_write_ping();
+        ping->seq = seq;
+        ping->check = ~seq;
+        ping->time = sent;
+        end_write_ping();
+        update_transport();
+        result.pings += num_slaves;
+
+        uint32_t answered = 0;
+        uint32_t all_answered = (1 << num_slaves) - 1;
+        while (answered != all_answered && virtual_link_time_us() - sent < timeout_us) {
+            virtual_link_poll(1);
+            update_transport();
+            for (uint8_t slave = 0; slave < num_slaves; slave++) {
+                ping_object_t* pong = read_pong(slave);
+                if (pong && pong->seq == seq) {
+                    if (pong->check != ~pong->seq || pong->time != sent) {
+                        result.bad_pongs++;
+                        continue;
+                    }
+                    uint64_t latency = virtual_link_time_us() - pong->time;
+                    result.total_latency_us += latency;
+                    result.max_latency_us = std::max(result.max_latency_us, latency);
+                    result.pongs++;
+                    answered |= 1 << slave;
+                }
+                state_object_t* state = read_slave_state(slave);
+                if (state && state->value == (slave + 1) * 1000u) {
+                    states_seen |= 1 << slave;
+                }
+            }
+        }
+    }
+    result.duration_us = virtual_link_time_us() - start;
+    result.states_received = states_seen == (1u << num_slaves) - 1;
+
+    const virtual_link_stats_t* stats = virtual_link_stats();
+    printf("%u slaves, %u pings: %.1f%% lost, latency %.0f us average %llu us max, "
+           "%.0f round trips/s, %u bytes sent by the master, %u corrupted, %u dropped, %u overrun\n",
+        num_slaves, result.pings,
+        100.0 * (result.pings - result.pongs) / result.pings,
+        result.pongs ? (double)result.total_latency_us / result.pongs : 0.0,
+        (unsigned long long)result.max_latency_us,
+        result.pongs * 1000000.0 / result.duration_us,
+        stats->bytes_sent, stats->bytes_corrupted, stats->bytes_dropped, stats->bytes_overrun);
+    result.bytes_overrun = stats->bytes_overrun;
+    virtual_link_stop();
+    return result;
+}
+
+TEST(VirtualLink, master_and_slave_exchange_every_ping) {
+    LinkResult result = run_link(2, virtual_link_config_t{0, 0}, 1000, CLEAN_LINK_TIMEOUT_US);
+    EXPECT_EQ(result.bytes_overrun, 0u);
+    EXPECT_EQ(result.pongs, result.pings);
+    EXPECT_EQ(result.bad_pongs, 0u);
+    EXPECT_TRUE(result.states_received);
+}
+
+TEST(VirtualLink, frames_are_routed_through_a_chain_of_slaves) {
+    LinkResult result = run_link(4, virtual_link_config_t{0, 0}, 500, CLEAN_LINK_TIMEOUT_US);
+    EXPECT_EQ(result.bytes_overrun, 0u);
+    EXPECT_EQ(result.pongs, result.pings);
+    EXPECT_EQ(result.bad_pongs, 0u);
+    EXPECT_TRUE(result.states_received);
+}
+
+TEST(VirtualLink, corrupted_frames_are_dropped_and_reliable_objects_arrive) {
+    LinkResult result = run_link(3, virtual_link_config_t{200, 0}, 500, LOSSY_LINK_TIMEOUT_US);
+    EXPECT_LT(result.pongs, result.pings);
+    EXPECT_GT(result.pongs, 0u);
+    EXPECT_EQ(result.bad_pongs, 0u);
+    EXPECT_TRUE(result.states_received);
+}
+
+TEST(VirtualLink, dropped_bytes_only_lose_frames) {
+    LinkResult result = run_link(2, virtual_link_config_t{0, 300}, 500, LOSSY_LINK_TIMEOUT_US);
+    EXPECT_GT(result.pongs, 0u);
+    EXPECT_EQ(result.bad_pongs, 0u);
+    EXPECT_TRUE(result.states_received);
+}
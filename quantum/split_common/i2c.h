@@ -13,10 +13,12 @@
 #define I2C_ACK 1
 #define I2C_NACK 0
 
-#define SLAVE_BUFFER_SIZE 0x10
+#define SLAVE_BUFFER_SIZE 0x20
 
 // i2c SCL clock frequency
+#ifndef SCL_CLOCK
 #define SCL_CLOCK  400000L
+#endif
 
 extern volatile uint8_t i2c_slave_buffer[SLAVE_BUFFER_SIZE];
 
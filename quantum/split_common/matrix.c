@@ -31,10 +31,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "config.h"
 #include "timer.h"
 
-#ifdef USE_I2C
-#  include "i2c.h"
-#else // USE_SERIAL
-#  include "serial.h"
+#include "transport.h"
+#ifdef SPLIT_EVENTS
+#  include "action.h"
 #endif
 
 #ifndef DEBOUNCING_DELAY
@@ -51,15 +50,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define print_matrix_row(row)  print_bin_reverse8(matrix_get_row(row))
 #    define matrix_bitpop(i)       bitpop(matrix[i])
 #    define ROW_SHIFTER ((uint8_t)1)
-#else
-#    error "Currently only supports 8 COLS"
+#elif (MATRIX_COLS <= 16)
+#    define print_matrix_header()  print("\nr/c 0123456789ABCDEF\n")
+#    define print_matrix_row(row)  print_bin_reverse16(matrix_get_row(row))
+#    define matrix_bitpop(i)       bitpop16(matrix[i])
+#    define ROW_SHIFTER ((uint16_t)1)
+#elif (MATRIX_COLS <= 32)
+#    define print_matrix_header()  print("\nr/c 0123456789ABCDEF0123456789ABCDEF\n")
+#    define print_matrix_row(row)  print_bin_reverse32(matrix_get_row(row))
+#    define matrix_bitpop(i)       bitpop32(matrix[i])
+#    define ROW_SHIFTER  ((uint32_t)1)
 #endif
-static matrix_row_t matrix_debouncing[MATRIX_ROWS];
 
 #define ERROR_DISCONNECT_COUNT 5
 
-#define ROWS_PER_HAND (MATRIX_ROWS/2)
-
 static uint8_t error_count = 0;
 
 static const uint8_t row_pins[MATRIX_ROWS] = MATRIX_ROW_PINS;
@@ -124,9 +128,6 @@ uint8_t matrix_cols(void)
 
 void matrix_init(void)
 {
-    debug_enable = true;
-    debug_matrix = true;
-    debug_mouse = true;
     // initialize row and col
 #if (DIODE_DIRECTION == COL2ROW)
     unselect_rows();
@@ -160,7 +161,6 @@ uint8_t _matrix_scan(void)
             if (matrix_changed) {
                 debouncing = true;
                 debouncing_time = timer_read();
-                PORTD ^= (1 << 2);
             }
 
 #       else
@@ -197,64 +197,153 @@ uint8_t _matrix_scan(void)
     return 1;
 }
 
-#ifdef USE_I2C
+#ifdef SPLIT_EVENTS
 
-// Get rows from other half over i2c
-int i2c_transaction(void) {
-    int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
+/*
+ * Key events of both halves are held for SPLIT_EVENTS_DELAY ms, long
+ * enough for the events of the slave to come in, and handed out in the
+ * order they happened. The time of an event is the last bounce of the
+ * key, on both halves.
+ */
+#ifndef SPLIT_EVENTS_DELAY
+#   define SPLIT_EVENTS_DELAY (DEBOUNCING_DELAY + 5)
+#endif
+#ifndef SPLIT_EVENTS_MASTER_QUEUE_SIZE
+#   define SPLIT_EVENTS_MASTER_QUEUE_SIZE 16
+#endif
 
-    int err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
-    if (err) goto i2c_error;
+// oldest first
+static keyevent_t events[SPLIT_EVENTS_MASTER_QUEUE_SIZE];
+static uint8_t event_count = 0;
+static uint16_t last_event_time = 0;
 
-    // start of matrix stored at 0x00
-    err = i2c_master_write(0x00);
-    if (err) goto i2c_error;
+// rows of this half as far as key events have been made for them
+static matrix_row_t reported[ROWS_PER_HAND];
 
-    // Start read
-    err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_READ);
-    if (err) goto i2c_error;
+static keyevent_t take_event(void)
+{
+    keyevent_t event = events[0];
+    event_count--;
+    for (uint8_t i = 0; i < event_count; i++) {
+        events[i] = events[i+1];
+    }
 
-    if (!err) {
-        int i;
-        for (i = 0; i < ROWS_PER_HAND-1; ++i) {
-            matrix[slaveOffset+i] = i2c_master_read(I2C_ACK);
-        }
-        matrix[slaveOffset+i] = i2c_master_read(I2C_NACK);
-        i2c_master_stop();
-    } else {
-i2c_error: // the cable is disconnceted, or something else went wrong
-        i2c_reset_state();
-        return err;
+    // an event that came in too late still goes after the ones handed out
+    if ((int16_t)(event.time - last_event_time) < 0) {
+        event.time = last_event_time;
     }
+    event.time |= 1; /* time should not be 0 */
+    last_event_time = event.time;
+    return event;
+}
 
-    return 0;
+/*
+ * Callers check for room first. While the queue is full, because the
+ * host or the action code holds the events back, the keys of this half
+ * are left unreported in the matrix and the slave keeps its events, so
+ * nothing is lost or handed out of order.
+ */
+static void queue_event(keyevent_t event)
+{
+    uint8_t i = event_count++;
+    for (; i > 0 && (int16_t)(event.time - events[i-1].time) < 0; i--) {
+        events[i] = events[i-1];
+    }
+    events[i] = event;
 }
 
-#else // USE_SERIAL
+keyevent_t split_event_next(void)
+{
+    uint16_t due = timer_read() - SPLIT_EVENTS_DELAY;
+
+    if (event_count && (int16_t)(events[0].time - due) <= 0) {
+        return take_event();
+    }
 
-int serial_transaction(void) {
-    int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
+    keyevent_t tick = TICK;
+    tick.time = due | 1;
+    if ((int16_t)(tick.time - last_event_time) < 0) {
+        tick.time = last_event_time;
+    }
+    last_event_time = tick.time;
+    return tick;
+}
+
+uint8_t transport_master_event_room(void)
+{
+    return SPLIT_EVENTS_MASTER_QUEUE_SIZE - event_count;
+}
+
+void transport_master_event(keyevent_t event)
+{
+    event.key.row += isLeftHand ? ROWS_PER_HAND : 0;
+    queue_event(event);
+}
+
+static void report_changes(matrix_row_t rows[], bool master)
+{
+#   if (DEBOUNCING_DELAY > 0)
+        uint16_t time = debouncing_time;
+#   else
+        uint16_t time = timer_read();
+#   endif
 
-    if (serial_update_buffers()) {
-        return 1;
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        matrix_row_t change = rows[row] ^ reported[row];
+        for (uint8_t col = 0; change && col < MATRIX_COLS; col++) {
+            if (change & (ROW_SHIFTER << col)) {
+                keyevent_t event = {
+                    .key = (keypos_t){ .row = row, .col = col },
+                    .pressed = rows[row] & (ROW_SHIFTER << col),
+                    .time = time
+                };
+                if (master) {
+                    if (event_count == SPLIT_EVENTS_MASTER_QUEUE_SIZE) {
+                        // reported once there is room
+                        return;
+                    }
+                    event.key.row += isLeftHand ? 0 : ROWS_PER_HAND;
+                    queue_event(event);
+                } else {
+                    transport_slave_event(event);
+                }
+                reported[row] ^= ROW_SHIFTER << col;
+            }
+        }
     }
+}
 
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        matrix[slaveOffset+i] = serial_slave_buffer[i];
+// Keys that do not fit in the queue stay pressed until a later scan
+static void release_row(uint8_t row)
+{
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        if (matrix[row] & (ROW_SHIFTER << col)) {
+            if (event_count == SPLIT_EVENTS_MASTER_QUEUE_SIZE) {
+                return;
+            }
+            queue_event((keyevent_t){
+                .key = (keypos_t){ .row = row, .col = col },
+                .pressed = false,
+                .time = timer_read()
+            });
+            matrix[row] &= ~(ROW_SHIFTER << col);
+        }
     }
-    return 0;
 }
+
 #endif
 
 uint8_t matrix_scan(void)
 {
     uint8_t ret = _matrix_scan();
 
-#ifdef USE_I2C
-    if( i2c_transaction() ) {
-#else // USE_SERIAL
-    if( serial_transaction() ) {
+    int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
+
+#ifdef SPLIT_EVENTS
+    report_changes(matrix + (isLeftHand ? 0 : ROWS_PER_HAND), true);
 #endif
+
+    if (!transport_master(matrix + slaveOffset)) {
         // turn on the indicator led when halves are disconnected
         TXLED1;
 
@@ -262,9 +351,12 @@ uint8_t matrix_scan(void)
 
         if (error_count > ERROR_DISCONNECT_COUNT) {
             // reset other half if disconnected
-            int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
             for (int i = 0; i < ROWS_PER_HAND; ++i) {
+#ifdef SPLIT_EVENTS
+                release_row(slaveOffset+i);
+#else
                 matrix[slaveOffset+i] = 0;
+#endif
             }
         }
     } else {
@@ -281,15 +373,10 @@ void matrix_slave_scan(void) {
 
     int offset = (isLeftHand) ? 0 : ROWS_PER_HAND;
 
-#ifdef USE_I2C
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        i2c_slave_buffer[i] = matrix[offset+i];
-    }
-#else // USE_SERIAL
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        serial_slave_buffer[i] = matrix[offset+i];
-    }
+#ifdef SPLIT_EVENTS
+    report_changes(matrix + offset, false);
 #endif
+    transport_slave(matrix + offset);
 }
 
 bool matrix_is_modified(void)
@@ -312,10 +399,11 @@ matrix_row_t matrix_get_row(uint8_t row)
 
 void matrix_print(void)
 {
-    print("\nr/c 0123456789ABCDEF\n");
+    print_matrix_header();
+
     for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
         phex(row); print(": ");
-        pbin_reverse16(matrix_get_row(row));
+        print_matrix_row(row);
         print("\n");
     }
 }
@@ -324,7 +412,7 @@ uint8_t matrix_key_count(void)
 {
     uint8_t count = 0;
     for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
-        count += bitpop16(matrix[i]);
+        count += matrix_bitpop(i);
     }
     return count;
 }
@@ -12,18 +12,11 @@
 #include <stdbool.h>
 #include "serial.h"
 
-#ifndef USE_I2C
-
-// Serial pulse period in microseconds. Its probably a bad idea to lower this
-// value.
-#define SERIAL_DELAY 24
+#if !defined(USE_I2C) && !defined(USE_SERIAL_USART)
 
 uint8_t volatile serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH] = {0};
 uint8_t volatile serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH] = {0};
 
-#define SLAVE_DATA_CORRUPT (1<<0)
-volatile uint8_t status = 0;
-
 inline static
 void serial_delay(void) {
   _delay_us(SERIAL_DELAY);
@@ -64,10 +57,10 @@ void serial_master_init(void) {
 void serial_slave_init(void) {
   serial_input();
 
-  // Enable INT0
-  EIMSK |= _BV(INT0);
-  // Trigger on falling edge of INT0
-  EICRA &= ~(_BV(ISC00) | _BV(ISC01));
+  // Enable the pin's interrupt
+  EIMSK |= SERIAL_PIN_INT_ENABLE;
+  // Trigger while the pin is low, the sense bits cleared
+  SERIAL_PIN_INT_SENSE_REG &= ~SERIAL_PIN_INT_SENSE_MASK;
 }
 
 // Used by the master to synchronize timing with the slave.
@@ -122,16 +115,13 @@ void serial_write_byte(uint8_t data) {
 
 // interrupt handle to be used by the slave device
 ISR(SERIAL_PIN_INTERRUPT) {
+  uint8_t size = serial_slave_frame_size(serial_slave_buffer[0]);
   sync_send();
 
-  uint8_t checksum = 0;
-  for (int i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+  for (uint8_t i = 0; i < size; ++i) {
     serial_write_byte(serial_slave_buffer[i]);
     sync_send();
-    checksum += serial_slave_buffer[i];
   }
-  serial_write_byte(checksum);
-  sync_send();
 
   // wait for the sync to finish sending
   serial_delay();
@@ -139,31 +129,17 @@ ISR(SERIAL_PIN_INTERRUPT) {
   // read the middle of pulses
   _delay_us(SERIAL_DELAY/2);
 
-  uint8_t checksum_computed = 0;
   for (int i = 0; i < SERIAL_MASTER_BUFFER_LENGTH; ++i) {
     serial_master_buffer[i] = serial_read_byte();
     sync_send();
-    checksum_computed += serial_master_buffer[i];
   }
-  uint8_t checksum_received = serial_read_byte();
-  sync_send();
 
   serial_input(); // end transaction
-
-  if ( checksum_computed != checksum_received ) {
-    status |= SLAVE_DATA_CORRUPT;
-  } else {
-    status &= ~SLAVE_DATA_CORRUPT;
-  }
-}
-
-inline
-bool serial_slave_DATA_CORRUPT(void) {
-  return status & SLAVE_DATA_CORRUPT;
 }
 
 // Copies the serial_slave_buffer to the master and sends the
-// serial_master_buffer to the slave.
+// serial_master_buffer to the slave. The buffers are framed and checked
+// by transport.c, this only moves the bytes.
 //
 // Returns:
 // 0 => no error
@@ -192,30 +168,20 @@ int serial_update_buffers(void) {
   // if the slave is present syncronize with it
   sync_recv();
 
-  uint8_t checksum_computed = 0;
-  // receive data from the slave
-  for (int i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+  // receive data from the slave, the first byte tells how much follows
+  serial_slave_buffer[0] = serial_read_byte();
+  sync_recv();
+  uint8_t size = serial_slave_frame_size(serial_slave_buffer[0]);
+  for (uint8_t i = 1; i < size; ++i) {
     serial_slave_buffer[i] = serial_read_byte();
     sync_recv();
-    checksum_computed += serial_slave_buffer[i];
   }
-  uint8_t checksum_received = serial_read_byte();
-  sync_recv();
 
-  if (checksum_computed != checksum_received) {
-    sei();
-    return 1;
-  }
-
-  uint8_t checksum = 0;
   // send data to the slave
   for (int i = 0; i < SERIAL_MASTER_BUFFER_LENGTH; ++i) {
     serial_write_byte(serial_master_buffer[i]);
     sync_recv();
-    checksum += serial_master_buffer[i];
   }
-  serial_write_byte(checksum);
-  sync_recv();
 
   // always, release the line when not in use
   serial_output();
@@ -0,0 +1,74 @@
+#ifndef MY_SERIAL_H
+#define MY_SERIAL_H
+
+#include "config.h"
+#include "matrix.h"
+#include <stdbool.h>
+
+// The serial pin and the external interrupt it is wired to, PD0/INT0 on
+// a Pro Micro. A board on another pin defines all of these in config.h.
+#ifndef SERIAL_PIN_DDR
+#  define SERIAL_PIN_DDR DDRD
+#  define SERIAL_PIN_PORT PORTD
+#  define SERIAL_PIN_INPUT PIND
+#  define SERIAL_PIN_MASK _BV(PD0)
+#  define SERIAL_PIN_INTERRUPT INT0_vect
+#  define SERIAL_PIN_INT_ENABLE _BV(INT0)
+#  define SERIAL_PIN_INT_SENSE_REG EICRA
+#  define SERIAL_PIN_INT_SENSE_MASK (_BV(ISC00) | _BV(ISC01))
+#endif
+
+// Serial pulse period in microseconds. Lower values give a faster link,
+// transport.c checks every frame so a link that is too fast for the
+// cable only shows up as dropped scans of the other half.
+#ifndef SERIAL_DELAY
+#  define SERIAL_DELAY 24
+#endif
+
+// USE_SERIAL_USART: baud rate of the USART link, and how many ms the
+// master waits for an answer before it counts the slave as missing
+#ifndef SERIAL_USART_SPEED
+#  define SERIAL_USART_SPEED 500000
+#endif
+#ifndef SERIAL_USART_TIMEOUT
+#  define SERIAL_USART_TIMEOUT 2
+#endif
+
+// The longest slave frame: header, all the rows of the slave half and a
+// CRC. With SPLIT_EVENTS the USART link takes frames as long as the
+// header allows. The bit banged link keeps interrupts off for the whole
+// transaction, about 0.2 ms a byte, so its frames stop at two key events
+// (header, clock, 2 events and CRC) or the rows and clock, whichever is
+// longer. The slave sends the rest of its events in the next frames.
+#ifndef SERIAL_SLAVE_BUFFER_LENGTH
+#  if defined(SPLIT_EVENTS) && defined(USE_SERIAL_USART)
+#    define SERIAL_SLAVE_BUFFER_LENGTH 32
+#  elif defined(SPLIT_EVENTS)
+#    define SERIAL_SLAVE_BUFFER_LENGTH (MATRIX_ROWS/2 * sizeof(matrix_row_t) > 8 ? \
+                                        MATRIX_ROWS/2 * sizeof(matrix_row_t) + 4 : 12)
+#  else
+#    define SERIAL_SLAVE_BUFFER_LENGTH (MATRIX_ROWS/2 * sizeof(matrix_row_t) + 2)
+#  endif
+#endif
+// Flags, backlight level and a CRC
+#ifndef SERIAL_MASTER_BUFFER_LENGTH
+#  define SERIAL_MASTER_BUFFER_LENGTH 3
+#endif
+
+// The low 5 bits of the first byte of a slave frame count the bytes that
+// follow it, so only the part of serial_slave_buffer in use goes over
+// the wire.
+static inline uint8_t serial_slave_frame_size(uint8_t header) {
+  uint8_t following = header & 0x1F;
+  return following < SERIAL_SLAVE_BUFFER_LENGTH ? following + 1 : SERIAL_SLAVE_BUFFER_LENGTH;
+}
+
+// Buffers for master - slave communication
+extern volatile uint8_t serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH];
+extern volatile uint8_t serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH];
+
+void serial_master_init(void);
+void serial_slave_init(void);
+int serial_update_buffers(void);
+
+#endif
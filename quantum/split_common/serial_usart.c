@@ -0,0 +1,185 @@
+/*
+ * Split transport on the USART in single wire half-duplex mode
+ *
+ * TXD1 (D3) and RXD1 (D2) are joined on each half, and the halves share
+ * that one wire. A transmitter is only enabled while it sends, the rest
+ * of the time the line idles high through the pull-up. Characters are
+ * 9 bits wide and the 9th bit marks the first byte of a frame, so a
+ * receiver always finds the start of the next frame.
+ *
+ * The master sends serial_master_buffer and the slave answers with the
+ * frame in serial_slave_buffer right from its receive interrupt. Everything runs
+ * from the interrupts; serial_update_buffers() only looks at how the
+ * last exchange went and starts the next one.
+ */
+
+#ifndef F_CPU
+#define F_CPU 16000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <stdbool.h>
+#include "timer.h"
+#include "serial.h"
+
+#ifdef USE_SERIAL_USART
+
+#define UBRR_VALUE ((F_CPU / (8UL * SERIAL_USART_SPEED)) - 1)
+
+// Gives the master time to release the line after its stop bit
+#define TURNAROUND_US (2 * 1000000.0 / SERIAL_USART_SPEED)
+
+#define RX_BUFFER_LENGTH (SERIAL_SLAVE_BUFFER_LENGTH > SERIAL_MASTER_BUFFER_LENGTH ? \
+                          SERIAL_SLAVE_BUFFER_LENGTH : SERIAL_MASTER_BUFFER_LENGTH)
+
+// rx_pos while waiting for the first byte of a frame
+#define RX_WAIT_START 0xFF
+
+uint8_t volatile serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH] = {0};
+uint8_t volatile serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH] = {0};
+
+static bool is_master = false;
+
+static volatile uint8_t *tx_data;
+static uint8_t tx_length;
+static uint8_t tx_pos;
+
+static uint8_t rx_buffer[RX_BUFFER_LENGTH];
+static volatile uint8_t *rx_target;
+static uint8_t rx_length;
+static uint8_t rx_pos = RX_WAIT_START;
+
+static volatile bool response_received = false;
+static bool transfer_started = false;
+static uint16_t transfer_time;
+static int last_result = 1;
+
+static void usart_init(void) {
+  UBRR1H = UBRR_VALUE >> 8;
+  UBRR1L = UBRR_VALUE;
+  UCSR1A = _BV(U2X1);
+  // 9 bit characters together with UCSZ12 in UCSR1B, no parity, 1 stop bit
+  UCSR1C = _BV(UCSZ11) | _BV(UCSZ10);
+
+  // both pins are inputs with pull-ups while the USART does not drive them
+  DDRD  &= ~(_BV(PD2) | _BV(PD3));
+  PORTD |=  (_BV(PD2) | _BV(PD3));
+}
+
+static void usart_idle(void) {
+  UCSR1B = _BV(UCSZ12);
+}
+
+static void usart_receive(void) {
+  rx_pos = RX_WAIT_START;
+  UCSR1B = _BV(UCSZ12) | _BV(RXEN1) | _BV(RXCIE1);
+}
+
+static void usart_transmit(volatile uint8_t *data, uint8_t length) {
+  tx_data = data;
+  tx_length = length;
+  tx_pos = 0;
+  UCSR1B = _BV(UCSZ12) | _BV(TXEN1) | _BV(UDRIE1);
+}
+
+void serial_master_init(void) {
+  is_master = true;
+  rx_target = serial_slave_buffer;
+  rx_length = SERIAL_SLAVE_BUFFER_LENGTH;
+  usart_init();
+  usart_idle();
+}
+
+void serial_slave_init(void) {
+  is_master = false;
+  rx_target = serial_master_buffer;
+  rx_length = SERIAL_MASTER_BUFFER_LENGTH;
+  usart_init();
+  usart_receive();
+}
+
+ISR(USART1_UDRE_vect) {
+  if (tx_pos == 0) {
+    UCSR1B |= _BV(TXB81);
+  } else {
+    UCSR1B &= ~_BV(TXB81);
+  }
+  UDR1 = tx_data[tx_pos++];
+
+  if (tx_pos == tx_length) {
+    // last byte queued, wait for it to leave the shift register
+    UCSR1A = _BV(U2X1) | _BV(TXC1);
+    UCSR1B = (UCSR1B & ~_BV(UDRIE1)) | _BV(TXCIE1);
+  }
+}
+
+ISR(USART1_TX_vect) {
+  // release the line and listen for the other half
+  usart_receive();
+}
+
+ISR(USART1_RX_vect) {
+  // the 9th bit has to be read before the data
+  bool first = UCSR1B & _BV(RXB81);
+  uint8_t data = UDR1;
+
+  if (first) {
+    rx_pos = 0;
+  }
+  if (rx_pos >= rx_length) {
+    return;
+  }
+  if (is_master && rx_pos == 0) {
+    // the header of a slave frame tells how much follows
+    rx_length = serial_slave_frame_size(data);
+  }
+  rx_buffer[rx_pos++] = data;
+  if (rx_pos < rx_length) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < rx_length; ++i) {
+    rx_target[i] = rx_buffer[i];
+  }
+
+  if (is_master) {
+    response_received = true;
+    usart_idle();
+  } else {
+    _delay_us(TURNAROUND_US);
+    usart_transmit(serial_slave_buffer, serial_slave_frame_size(serial_slave_buffer[0]));
+  }
+}
+
+// Checks on the last exchange and starts the next one, never waits.
+// serial_slave_buffer keeps the last frame the slave sent.
+//
+// Returns:
+// 0 => the last exchange went through
+// 1 => the slave has not answered
+int serial_update_buffers(void) {
+  if (transfer_started) {
+    if (response_received) {
+      last_result = 0;
+    } else if (timer_elapsed(transfer_time) < SERIAL_USART_TIMEOUT) {
+      // still under way
+      return last_result;
+    } else {
+      last_result = 1;
+    }
+  }
+
+  uint8_t sreg = SREG;
+  cli();
+  response_received = false;
+  transfer_started = true;
+  transfer_time = timer_read();
+  usart_transmit(serial_master_buffer, SERIAL_MASTER_BUFFER_LENGTH);
+  SREG = sreg;
+
+  return last_result;
+}
+
+#endif
@@ -9,12 +9,7 @@
 #include "keyboard.h"
 #include "config.h"
 #include "timer.h"
-
-#ifdef USE_I2C
-#  include "i2c.h"
-#else
-#  include "serial.h"
-#endif
+#include "transport.h"
 
 volatile bool isLeftHand = true;
 
@@ -32,23 +27,15 @@ static void setup_handedness(void) {
 }
 
 static void keyboard_master_setup(void) {
-#ifdef USE_I2C
-    i2c_master_init();
-#ifdef SSD1306OLED
+    transport_master_init();
+#if defined(USE_I2C) && defined(SSD1306OLED)
     matrix_master_OLED_init ();
 #endif
-#else
-    serial_master_init();
-#endif
 }
 
 static void keyboard_slave_setup(void) {
   timer_init();
-#ifdef USE_I2C
-    i2c_slave_init(SLAVE_I2C_ADDRESS);
-#else
-    serial_slave_init();
-#endif
+  transport_slave_init();
 }
 
 bool has_usb(void) {
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include "eeconfig.h"
+#ifdef SPLIT_EVENTS
+#  include "keyboard.h"
+#endif
 
 #define SLAVE_I2C_ADDRESS           0x32
 
@@ -11,6 +14,12 @@ extern volatile bool isLeftHand;
 // slave version of matix scan, defined in matrix.c
 void matrix_slave_scan(void);
 
+#ifdef SPLIT_EVENTS
+// The next key event of either half in the order they happened, or a
+// tick when none is due yet. Defined in matrix.c
+keyevent_t split_event_next(void);
+#endif
+
 void split_keyboard_setup(void);
 bool has_usb(void);
 void keyboard_slave_loop(void);
@@ -0,0 +1,597 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "config.h"
+#include "matrix.h"
+#include "split_util.h"
+#include "transport.h"
+#ifdef SPLIT_EVENTS
+#  include "timer.h"
+#  include "ring_buffer.h"
+#endif
+#ifdef BACKLIGHT_ENABLE
+#  include "backlight.h"
+#endif
+
+#ifdef USE_I2C
+#  include "i2c.h"
+#else // USE_SERIAL or USE_SERIAL_USART
+#  include "serial.h"
+#endif
+
+/*
+ * The halves take turns: the master sends a frame, the slave answers
+ * with one. Every frame ends in a CRC-8 of its contents, so bit errors
+ * on the cable and frames read while the other side was still updating
+ * them are dropped instead of showing up as stray key presses.
+ *
+ * The slave only sends the rows that changed:
+ *
+ *   header:  bit 7 full frame, bits 6-5 sequence number,
+ *            bits 4-0 number of bytes after the header
+ *   payload: nothing for a heartbeat,
+ *            row index and row for every changed row,
+ *            or all the rows in a full frame
+ *   CRC
+ *
+ * Changed rows are counted against the rows the master has
+ * acknowledged, and the sequence number moves on once per change. Only
+ * one change is in flight at a time: the slave repeats it until the
+ * master acknowledges its sequence number, then sends the next one.
+ * When the master sees a frame it cannot apply, after a restart of
+ * either half or a missed frame, it asks for a full frame.
+ *
+ *   master:  bit 7 resync, bits 6-5 last sequence number applied
+ *            backlight level
+ *            CRC
+ */
+#define ROWS_SIZE (ROWS_PER_HAND * sizeof(matrix_row_t))
+#define MASTER_FRAME_SIZE 3
+
+#define I2C_ROWS_START 0x00
+#define I2C_MASTER_START 0x10
+
+#ifndef SPLIT_EVENTS
+#  define SLAVE_FRAME_MAX (ROWS_SIZE + 2)
+#elif defined(USE_I2C)
+#  define SLAVE_FRAME_MAX (I2C_MASTER_START - I2C_ROWS_START)
+#else
+#  define SLAVE_FRAME_MAX SERIAL_SLAVE_BUFFER_LENGTH
+#endif
+
+#define HEADER_FULL 0x80
+#define HEADER_SEQ(header) (((header) >> 5) & 3)
+#define HEADER_LENGTH(header) ((header) & 0x1F)
+#define MASTER_RESYNC 0x80
+#define NEXT_SEQ(seq) (((seq) + 1) & 3)
+
+typedef char rows_must_fit_in_a_frame[ROWS_SIZE + 1 <= HEADER_LENGTH(0xFF) ? 1 : -1];
+typedef char frame_length_must_fit_in_header[SLAVE_FRAME_MAX - 1 <= HEADER_LENGTH(0xFF) ? 1 : -1];
+
+// CRC-8 with polynomial 0x07
+static const uint8_t crc8_table[256] PROGMEM = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
+    0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5,
+    0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85,
+    0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
+    0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2,
+    0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32,
+    0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
+    0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C,
+    0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC,
+    0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
+    0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C,
+    0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B,
+    0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
+    0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB,
+    0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB,
+    0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+
+// Starts from 0xFF so a buffer of zeros is never a valid frame
+static uint8_t crc8(const volatile uint8_t *data, uint8_t len) {
+    uint8_t crc = 0xFF;
+    while (len--) {
+        crc = pgm_read_byte(&crc8_table[crc ^ *data++]);
+    }
+    return crc;
+}
+
+static void copy_frame(volatile uint8_t *dst, const volatile uint8_t *src, uint8_t len) {
+    while (len--) {
+        *dst++ = *src++;
+    }
+}
+
+#ifdef BACKLIGHT_ENABLE
+static void slave_set_backlight(uint8_t level) {
+    static uint8_t current_level = 0xFF;
+    if (level != current_level) {
+        current_level = level;
+        backlight_set(level);
+    }
+}
+#endif
+
+#ifdef USE_I2C
+
+typedef char rows_must_fit_before_master_data[SLAVE_FRAME_MAX <= I2C_MASTER_START ? 1 : -1];
+typedef char master_data_must_fit_in_buffer[I2C_MASTER_START + MASTER_FRAME_SIZE <= SLAVE_BUFFER_SIZE ? 1 : -1];
+
+void transport_master_init(void) {
+    i2c_master_init();
+}
+
+void transport_slave_init(void) {
+    i2c_slave_init(SLAVE_I2C_ADDRESS);
+}
+
+static bool master_exchange(const uint8_t *master_frame, uint8_t *slave_frame) {
+    static uint8_t written_frame[MASTER_FRAME_SIZE];
+
+    int err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
+    if (err) goto i2c_error;
+
+    // start of the slave frame stored at I2C_ROWS_START
+    err = i2c_master_write(I2C_ROWS_START);
+    if (err) goto i2c_error;
+
+    // Start read, the header tells how much follows
+    err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_READ);
+    if (err) goto i2c_error;
+
+    slave_frame[0] = i2c_master_read(I2C_ACK);
+    uint8_t length = HEADER_LENGTH(slave_frame[0]);
+    if (length == 0 || length >= SLAVE_FRAME_MAX) {
+        length = 1;
+    }
+    uint8_t i;
+    for (i = 1; i < length; ++i) {
+        slave_frame[i] = i2c_master_read(I2C_ACK);
+    }
+    slave_frame[i] = i2c_master_read(I2C_NACK);
+    i2c_master_stop();
+
+    // the slave reads the master frame whenever it likes, so only
+    // write it when it changes
+    if (memcmp(written_frame, master_frame, MASTER_FRAME_SIZE)) {
+        err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
+        if (err) goto i2c_error;
+
+        err = i2c_master_write(I2C_MASTER_START);
+        if (err) goto i2c_error;
+
+        for (i = 0; i < MASTER_FRAME_SIZE; ++i) {
+            err = i2c_master_write(master_frame[i]);
+            if (err) goto i2c_error;
+        }
+        i2c_master_stop();
+        memcpy(written_frame, master_frame, MASTER_FRAME_SIZE);
+    }
+    return true;
+
+i2c_error: // the cable is disconnceted, or something else went wrong
+    i2c_reset_state();
+    memset(written_frame, 0, MASTER_FRAME_SIZE);
+    return false;
+}
+
+static void slave_publish(const uint8_t *frame, uint8_t size) {
+    copy_frame(&i2c_slave_buffer[I2C_ROWS_START], frame, size);
+}
+
+static void slave_master_frame(uint8_t *frame) {
+    copy_frame(frame, &i2c_slave_buffer[I2C_MASTER_START], MASTER_FRAME_SIZE);
+}
+
+#else // USE_SERIAL or USE_SERIAL_USART
+
+typedef char slave_frame_must_fit_in_slave_buffer[SLAVE_FRAME_MAX <= SERIAL_SLAVE_BUFFER_LENGTH ? 1 : -1];
+typedef char master_frame_must_fit_in_master_buffer[MASTER_FRAME_SIZE <= SERIAL_MASTER_BUFFER_LENGTH ? 1 : -1];
+
+void transport_master_init(void) {
+    serial_master_init();
+}
+
+void transport_slave_init(void) {
+    serial_slave_init();
+}
+
+static bool master_exchange(const uint8_t *master_frame, uint8_t *slave_frame) {
+    copy_frame(serial_master_buffer, master_frame, MASTER_FRAME_SIZE);
+
+    if (serial_update_buffers()) {
+        return false;
+    }
+
+    copy_frame(slave_frame, serial_slave_buffer, SLAVE_FRAME_MAX);
+    return true;
+}
+
+static void slave_publish(const uint8_t *frame, uint8_t size) {
+    copy_frame(serial_slave_buffer, frame, size);
+}
+
+static void slave_master_frame(uint8_t *frame) {
+    copy_frame(frame, serial_master_buffer, MASTER_FRAME_SIZE);
+}
+
+#endif
+
+#ifdef SPLIT_EVENTS
+
+/*
+ * With SPLIT_EVENTS the slave sends its key events instead of its rows,
+ * each with the time it happened on the clock of the slave:
+ *
+ *   header:  bit 7 full frame, bits 6-5 sequence number,
+ *            bits 4-0 number of bytes after the header
+ *   clock of the slave when the frame was written
+ *   payload: nothing for a heartbeat,
+ *            row (bit 7 pressed), column and time of each key event,
+ *            or all the rows in a full frame
+ *   CRC
+ *
+ * The master moves every time onto its own clock by the age of the
+ * event. A batch of events is repeated until the master acknowledges
+ * its sequence number. When the master asks for a resync the slave
+ * drops the events it has not sent and sends its rows instead, and the
+ * master makes up the events between the rows it had and those.
+ */
+#define EVENT_SIZE 4
+#define EVENT_PRESSED 0x80
+#define EVENTS_PER_FRAME ((SLAVE_FRAME_MAX - 4) / EVENT_SIZE)
+
+#ifndef SPLIT_EVENTS_QUEUE_SIZE
+#  define SPLIT_EVENTS_QUEUE_SIZE 16
+#endif
+
+typedef char rows_must_fit_in_an_event_frame[ROWS_SIZE + 4 <= SLAVE_FRAME_MAX ? 1 : -1];
+typedef char an_event_must_fit_in_a_frame[EVENTS_PER_FRAME > 0 ? 1 : -1];
+
+/*
+ * Master
+ */
+static uint8_t master_seq = 0;
+static bool need_resync = true;
+
+static void master_key_event(matrix_row_t slave_matrix[], uint8_t row, uint8_t col, bool pressed, uint16_t time) {
+    if (pressed) {
+        slave_matrix[row] |= (matrix_row_t)1 << col;
+    } else {
+        slave_matrix[row] &= ~((matrix_row_t)1 << col);
+    }
+    transport_master_event((keyevent_t){
+        .key = (keypos_t){ .row = row, .col = col },
+        .pressed = pressed,
+        .time = time
+    });
+}
+
+// Returns false if the frame is corrupt
+static bool master_apply(matrix_row_t slave_matrix[], const uint8_t *frame) {
+    uint8_t header = frame[0];
+    uint8_t length = HEADER_LENGTH(header);
+
+    if (length < 3 || length >= SLAVE_FRAME_MAX || crc8(frame, length) != frame[length]) {
+        return false;
+    }
+
+    uint16_t now = timer_read();
+    uint16_t slave_now = frame[1] | (frame[2] << 8);
+    uint8_t seq = HEADER_SEQ(header);
+
+    if (header & HEADER_FULL) {
+        if (length != ROWS_SIZE + 3) {
+            return false;
+        }
+        matrix_row_t rows[ROWS_PER_HAND];
+        memcpy(rows, &frame[3], ROWS_SIZE);
+        uint8_t room = transport_master_event_room();
+        for (uint8_t row = 0; row < ROWS_PER_HAND; ++row) {
+            matrix_row_t change = rows[row] ^ slave_matrix[row];
+            for (uint8_t col = 0; change && col < MATRIX_COLS; ++col) {
+                if (change & ((matrix_row_t)1 << col)) {
+                    if (!room) {
+                        // the rest waits for the next full frame
+                        return true;
+                    }
+                    master_key_event(slave_matrix, row, col, rows[row] & ((matrix_row_t)1 << col), now);
+                    room--;
+                }
+            }
+        }
+        master_seq = seq;
+        need_resync = false;
+        return true;
+    }
+
+    if (need_resync || seq == master_seq) {
+        // waiting for a full frame, a heartbeat or a repeat
+        return true;
+    }
+    if (seq != NEXT_SEQ(master_seq)) {
+        need_resync = true;
+        return true;
+    }
+
+    // check all the events before applying any of them
+    for (uint8_t i = 3; i + EVENT_SIZE <= length; i += EVENT_SIZE) {
+        if ((frame[i] & ~EVENT_PRESSED) >= ROWS_PER_HAND || frame[i + 1] >= MATRIX_COLS) {
+            need_resync = true;
+            return true;
+        }
+    }
+    if ((length - 3) / EVENT_SIZE > transport_master_event_room()) {
+        // not acknowledged, the slave repeats the batch
+        return true;
+    }
+    for (uint8_t i = 3; i + EVENT_SIZE <= length; i += EVENT_SIZE) {
+        uint16_t time = frame[i + 2] | (frame[i + 3] << 8);
+        master_key_event(slave_matrix, frame[i] & ~EVENT_PRESSED, frame[i + 1],
+                         frame[i] & EVENT_PRESSED, now - (uint16_t)(slave_now - time));
+    }
+    master_seq = seq;
+    return true;
+}
+
+#else
+
+/*
+ * Master
+ */
+static uint8_t master_seq = 0;
+static bool need_resync = true;
+
+// Returns false if the frame is corrupt
+static bool master_apply(matrix_row_t slave_matrix[], const uint8_t *frame) {
+    uint8_t header = frame[0];
+    uint8_t length = HEADER_LENGTH(header);
+
+    if (length == 0 || length >= SLAVE_FRAME_MAX || crc8(frame, length) != frame[length]) {
+        return false;
+    }
+
+    uint8_t seq = HEADER_SEQ(header);
+    if (header & HEADER_FULL) {
+        if (length != ROWS_SIZE + 1) {
+            return false;
+        }
+        memcpy(slave_matrix, &frame[1], ROWS_SIZE);
+        master_seq = seq;
+        need_resync = false;
+        return true;
+    }
+
+    if (need_resync || seq == master_seq) {
+        // waiting for a full frame, a heartbeat or a repeat
+        return true;
+    }
+    if (seq != NEXT_SEQ(master_seq)) {
+        need_resync = true;
+        return true;
+    }
+
+    // row index and row for every changed row, up to the CRC
+    for (uint8_t i = 1; i + sizeof(matrix_row_t) < length; i += 1 + sizeof(matrix_row_t)) {
+        uint8_t row = frame[i];
+        if (row >= ROWS_PER_HAND) {
+            need_resync = true;
+            return true;
+        }
+        memcpy(&slave_matrix[row], &frame[i + 1], sizeof(matrix_row_t));
+    }
+    master_seq = seq;
+    return true;
+}
+
+#endif
+
+bool transport_master(matrix_row_t slave_matrix[]) {
+    uint8_t master_frame[MASTER_FRAME_SIZE];
+    uint8_t slave_frame[SLAVE_FRAME_MAX];
+
+    master_frame[0] = (need_resync ? MASTER_RESYNC : 0) | (master_seq << 5);
+#ifdef BACKLIGHT_ENABLE
+    // Write backlight level for slave to read
+    master_frame[1] = get_backlight_level();
+#else
+    master_frame[1] = 0;
+#endif
+    master_frame[2] = crc8(master_frame, 2);
+
+    if (!master_exchange(master_frame, slave_frame)) {
+#ifdef SPLIT_EVENTS
+        // the slave may have missed key events while it was away
+        need_resync = true;
+#endif
+        return false;
+    }
+    return master_apply(slave_matrix, slave_frame);
+}
+
+#ifdef SPLIT_EVENTS
+
+/*
+ * Slave
+ */
+RING_BUFFER(key_events, keyevent_t, SPLIT_EVENTS_QUEUE_SIZE)
+
+// the last sequence number the master acknowledged
+static uint8_t base_seq = 0;
+// the batch in flight, none while sent_seq is the same as base_seq
+static uint8_t sent_seq = 0;
+static bool sent_full = false;
+static uint8_t sent_count = 0;
+static keyevent_t sent_events[EVENTS_PER_FRAME];
+static matrix_row_t sent_rows[ROWS_PER_HAND];
+static bool send_full = true;
+
+void transport_slave_event(keyevent_t event) {
+    if (!key_events_put(event)) {
+        // the master has fallen behind, catch it up with the rows
+        send_full = true;
+    }
+}
+
+static uint8_t slave_build_frame(uint8_t *frame) {
+    uint16_t now = timer_read();
+    uint8_t length = 3;
+
+    frame[1] = now;
+    frame[2] = now >> 8;
+    if (sent_seq == base_seq) {
+        frame[0] = base_seq << 5;
+    } else if (sent_full) {
+        frame[0] = HEADER_FULL | (sent_seq << 5);
+        memcpy(&frame[3], sent_rows, ROWS_SIZE);
+        length += ROWS_SIZE;
+    } else {
+        frame[0] = sent_seq << 5;
+        for (uint8_t i = 0; i < sent_count; ++i) {
+            frame[length++] = sent_events[i].key.row | (sent_events[i].pressed ? EVENT_PRESSED : 0);
+            frame[length++] = sent_events[i].key.col;
+            frame[length++] = sent_events[i].time;
+            frame[length++] = sent_events[i].time >> 8;
+        }
+    }
+
+    frame[0] |= length;
+    frame[length] = crc8(frame, length);
+    return length + 1;
+}
+
+void transport_slave(matrix_row_t slave_matrix[]) {
+    uint8_t master_frame[MASTER_FRAME_SIZE];
+    uint8_t slave_frame[SLAVE_FRAME_MAX];
+
+    slave_master_frame(master_frame);
+    if (crc8(master_frame, 2) == master_frame[2]) {
+        if (master_frame[0] & MASTER_RESYNC) {
+            // unless the rows are on their way already
+            if (sent_seq == base_seq || !sent_full) {
+                send_full = true;
+            }
+        } else if (sent_seq != base_seq && HEADER_SEQ(master_frame[0]) == sent_seq) {
+            base_seq = sent_seq;
+        }
+#ifdef BACKLIGHT_ENABLE
+        // Read backlight level sent from master and update level on slave
+        slave_set_backlight(master_frame[1]);
+#endif
+    }
+
+    if (send_full) {
+        // the rows take the place of every event not acknowledged yet
+        key_events_clear();
+        memcpy(sent_rows, slave_matrix, ROWS_SIZE);
+        sent_seq = NEXT_SEQ(base_seq);
+        sent_full = true;
+        send_full = false;
+    } else if (sent_seq == base_seq && key_events_has_data()) {
+        sent_count = 0;
+        while (sent_count < EVENTS_PER_FRAME && key_events_get(&sent_events[sent_count])) {
+            sent_count++;
+        }
+        sent_seq = NEXT_SEQ(base_seq);
+        sent_full = false;
+    }
+
+    uint8_t size = slave_build_frame(slave_frame);
+    slave_publish(slave_frame, size);
+}
+
+#else
+
+/*
+ * Slave
+ */
+// rows the master has acknowledged
+static matrix_row_t base_rows[ROWS_PER_HAND];
+static uint8_t base_seq = 0;
+// the change in flight, the same as base while there is none
+static matrix_row_t sent_rows[ROWS_PER_HAND];
+static uint8_t sent_seq = 0;
+static bool sent_full = false;
+static bool send_full = true;
+
+static uint8_t slave_build_frame(uint8_t *frame) {
+    uint8_t length = 1;
+
+    if (sent_seq == base_seq) {
+        frame[0] = base_seq << 5;
+    } else {
+        frame[0] = sent_seq << 5;
+        for (uint8_t row = 0; row < ROWS_PER_HAND && !sent_full; ++row) {
+            if (sent_rows[row] == base_rows[row]) {
+                continue;
+            }
+            if (length + sizeof(matrix_row_t) > ROWS_SIZE) {
+                // the changes take more room than all the rows
+                sent_full = true;
+                break;
+            }
+            frame[length++] = row;
+            memcpy(&frame[length], &sent_rows[row], sizeof(matrix_row_t));
+            length += sizeof(matrix_row_t);
+        }
+        if (sent_full) {
+            frame[0] |= HEADER_FULL;
+            memcpy(&frame[1], sent_rows, ROWS_SIZE);
+            length = ROWS_SIZE + 1;
+        }
+    }
+
+    frame[0] |= length;
+    frame[length] = crc8(frame, length);
+    return length + 1;
+}
+
+void transport_slave(matrix_row_t slave_matrix[]) {
+    uint8_t master_frame[MASTER_FRAME_SIZE];
+    uint8_t slave_frame[SLAVE_FRAME_MAX];
+
+    slave_master_frame(master_frame);
+    if (crc8(master_frame, 2) == master_frame[2]) {
+        if (master_frame[0] & MASTER_RESYNC) {
+            send_full = true;
+            sent_full = true;
+        } else if (sent_seq != base_seq && HEADER_SEQ(master_frame[0]) == sent_seq) {
+            memcpy(base_rows, sent_rows, ROWS_SIZE);
+            base_seq = sent_seq;
+        }
+#ifdef BACKLIGHT_ENABLE
+        // Read backlight level sent from master and update level on slave
+        slave_set_backlight(master_frame[1]);
+#endif
+    }
+
+    if (sent_seq == base_seq && (send_full || memcmp(slave_matrix, base_rows, ROWS_SIZE))) {
+        memcpy(sent_rows, slave_matrix, ROWS_SIZE);
+        sent_seq = NEXT_SEQ(base_seq);
+        sent_full = send_full;
+        send_full = false;
+    }
+
+    uint8_t size = slave_build_frame(slave_frame);
+    slave_publish(slave_frame, size);
+}
+
+#endif
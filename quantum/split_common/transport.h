@@ -0,0 +1,36 @@
+#ifndef SPLIT_TRANSPORT_H
+#define SPLIT_TRANSPORT_H
+
+#include <stdbool.h>
+#include "matrix.h"
+#ifdef SPLIT_EVENTS
+#  include "keyboard.h"
+#endif
+
+#define ROWS_PER_HAND (MATRIX_ROWS/2)
+
+void transport_master_init(void);
+void transport_slave_init(void);
+
+// Exchange data with the slave half, filling in its rows.
+// Returns false if the slave did not answer or its frame was corrupt,
+// the rows are left alone then.
+bool transport_master(matrix_row_t slave_matrix[]);
+// Publish the rows of this half for the master to read, and apply
+// whatever the master sent.
+void transport_slave(matrix_row_t slave_matrix[]);
+
+#ifdef SPLIT_EVENTS
+// Queue a key event of the slave for the master, rows counted from the
+// first row of this half.
+void transport_slave_event(keyevent_t event);
+// Called by transport_master() for every key event of the slave, with
+// the time on the clock of the master. It has been applied to the rows
+// already.
+void transport_master_event(keyevent_t event);
+// How many more key events transport_master_event() can take. A batch
+// that does not fit is left with the slave, which sends it again.
+uint8_t transport_master_event_room(void);
+#endif
+
+#endif
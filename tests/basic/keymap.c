@@ -21,11 +21,15 @@
 
 #define COMBO1 RSFT(LCTL(KC_O))
 
+enum custom_keycodes {
+    SEND_AB = SAFE_RANGE,
+};
+
 const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
     [0] = {
         // 0    1      2      3        4        5        6       7            8      9
         {KC_A,  KC_B,  KC_NO, KC_LSFT, KC_RSFT, KC_LCTL, COMBO1, SFT_T(KC_P), M(0),  KC_NO},
-        {KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
+        {SEND_AB, KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
         {KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
         {KC_C,  KC_D,  KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
     },
@@ -43,4 +47,12 @@ const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt) {
 };
 
 void action_function(keyrecord_t *record, uint8_t id, uint8_t opt) {
-}
\ No newline at end of file
+}
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (keycode == SEND_AB && record->event.pressed) {
+        send_string("ab");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+using testing::InvokeWithoutArgs;
+
+class HostReady : public TestFixture {};
+
+TEST_F(HostReady, KeysWaitWhileTheHostIsBusy) {
+    TestDriver driver;
+    driver.set_ready(false);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    keyboard_task();
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    driver.set_ready(true);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    keyboard_task();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
+
+TEST_F(HostReady, SendStringGivesUpWaitingForAHostThatNeverPolls) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 1);
+    // the host stops polling once the first report is queued
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)))
+        .WillOnce(InvokeWithoutArgs([&driver]() { driver.set_ready(false); }));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    uint32_t start = timer_read32();
+    keyboard_task();
+    EXPECT_GE(timer_read32() - start, SEND_STRING_HOST_TIMEOUT);
+    release_key(0, 1);
+    driver.set_ready(true);
+    keyboard_task();
+}
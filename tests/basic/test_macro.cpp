@@ -17,6 +17,8 @@
 #include "test_common.hpp"
 #include "time.h"
 
+using testing::_;
+using testing::AnyNumber;
 using testing::InSequence;
 using testing::InvokeWithoutArgs;
 
@@ -24,6 +26,32 @@ class Macro : public TestFixture {};
 
 #define AT_TIME(t) WillOnce(InvokeWithoutArgs([current_time]() {EXPECT_EQ(timer_elapsed32(current_time), t);}))
 
+// The reports a macro sends before its first WAIT, one per key command
+static int reports_before_wait(const macro_t *macro) {
+    int reports = 0;
+    while (true) {
+        macro_t command = *macro++;
+        if (command == WAIT || command == END) {
+            return reports;
+        }
+        if (command == INTERVAL) {
+            macro++;
+            continue;
+        }
+        if (command == KEY_DOWN || command == KEY_UP) {
+            macro++;
+        }
+        reports++;
+    }
+}
+
+static const macro_t *macro_on_key(uint8_t col, uint8_t row) {
+    keyrecord_t record = {};
+    record.event.key = {.col = col, .row = row};
+    record.event.pressed = true;
+    return action_get_macro(&record, 0, 0);
+}
+
 TEST_F(Macro, PlayASimpleMacro) {
     TestDriver driver;
     InSequence s;
@@ -95,5 +123,56 @@ TEST_F(Macro, PlayASimpleMacro) {
         .AT_TIME(210);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
         .AT_TIME(220);
+    // The delays are waited for by the following scans
+    idle_for(221);
+}
+
+TEST_F(Macro, KeysAreProcessedWhileAMacroWaits) {
+    TestDriver driver;
+    InSequence s;
+    press_key(8, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(reports_before_wait(macro_on_key(8, 0)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_TRUE(action_macro_busy());
+    // The macro is in its W(100) now
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    release_key(8, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    idle_for(250);
+    EXPECT_FALSE(action_macro_busy());
+}
+TEST_F(Macro, KeysWaitWhileTheMacroQueueIsFull) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    // One macro plays, the rest fill the queue behind it
+    for (int i = 0; i < ACTION_MACRO_QUEUE_SIZE + 1; i++) {
+        press_key(8, 0);
+        run_one_scan_loop();
+        release_key(8, 0);
+        run_one_scan_loop();
+    }
+    EXPECT_TRUE(action_macro_queue_full());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    // The scan goes on and A is held back, not typed into the macros
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
     run_one_scan_loop();
-}
\ No newline at end of file
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    release_key(0, 0);
+    bool a_sent = false;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(testing::Invoke([&a_sent](report_keyboard_t& report) {
+        if (report.keys[0] == KC_A) {
+            EXPECT_FALSE(action_macro_queue_full());
+            a_sent = true;
+        }
+    }));
+    idle_for(300 * (ACTION_MACRO_QUEUE_SIZE + 1));
+    EXPECT_TRUE(a_sent);
+    EXPECT_FALSE(action_macro_busy());
+}
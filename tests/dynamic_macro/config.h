@@ -0,0 +1,27 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTS_DYNAMIC_MACRO_CONFIG_H_
+#define TESTS_DYNAMIC_MACRO_CONFIG_H_
+
+#define MATRIX_ROWS 1
+#define MATRIX_COLS 12
+
+#define DYNAMIC_MACRO_SIZE 64
+#define DYNAMIC_MACRO_SLOTS 4
+#define DYNAMIC_MACRO_EEPROM_ADDR 32
+
+#endif /* TESTS_DYNAMIC_MACRO_CONFIG_H_ */
@@ -0,0 +1,43 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+enum test_keycodes {
+    DYNAMIC_MACRO_RANGE = SAFE_RANGE,
+};
+
+#include "dynamic_macro.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        // 0             1               2             3                4                5     6     7
+        {DYN_REC_START1, DYN_REC_START2, DYN_REC_STOP, DYN_MACRO_PLAY1, DYN_MACRO_PLAY2, KC_A, KC_B, KC_C,
+        // 8               9                 10                 11
+         DYN_REC_START(3), DYN_REC_START(4), DYN_MACRO_PLAY(3), DYN_MACRO_PLAY(4)},
+    },
+};
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return process_record_dynamic_macro(keycode, record);
+}
+
+// Forgets the macros in RAM and loads them back, like a power cycle
+void dynamic_macro_reboot(void) {
+    memset(dynamic_macro_slots, 0, sizeof(dynamic_macro_slots));
+    dynamic_macro_used = 0;
+    dynamic_macro_load();
+}
@@ -0,0 +1,127 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+extern "C" {
+#include "eeprom.h"
+    void dynamic_macro_reboot(void);
+}
+
+class DynamicMacro : public TestFixture {
+protected:
+    void tap(uint8_t col) {
+        press_key(col, 0);
+        run_one_scan_loop();
+        release_key(col, 0);
+        run_one_scan_loop();
+    }
+
+    void record(uint8_t start_col, std::initializer_list<uint8_t> cols) {
+        tap(start_col);
+        for (uint8_t col : cols) {
+            tap(col);
+        }
+        // Stop while holding the key, the way a layer key would be used
+        press_key(2, 0);
+        run_one_scan_loop();
+        release_key(2, 0);
+        run_one_scan_loop();
+    }
+
+    // Returns the keys sent while playing the macro with the given key
+    std::vector<uint8_t> play(TestDriver& driver, uint8_t col) {
+        std::vector<uint8_t> keys;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([&keys](report_keyboard_t& report) {
+            if (report.keys[0] != 0) {
+                keys.push_back(report.keys[0]);
+            }
+        }));
+        tap(col);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        return keys;
+    }
+};
+
+TEST_F(DynamicMacro, RecordedKeysArePlayedBack) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    record(0, {5, 6, 5});
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(play(driver, 3), std::vector<uint8_t>({KC_A, KC_B, KC_A}));
+}
+
+TEST_F(DynamicMacro, RerecordingAMacroKeepsTheOthers) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    record(0, {5, 5});
+    record(1, {6, 7});
+    // Slot 1 is stored before slot 2, so this moves slot 2 down
+    record(0, {7});
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(play(driver, 3), std::vector<uint8_t>({KC_C}));
+    EXPECT_EQ(play(driver, 4), std::vector<uint8_t>({KC_B, KC_C}));
+}
+
+TEST_F(DynamicMacro, ExtraSlotsAreRecordedAndPlayedBack) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    record(0, {5});
+    record(8, {6, 6});
+    record(9, {7, 5});
+    // Slot 3 sits between slots 1 and 4, re-recording it moves slot 4
+    record(8, {7});
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(play(driver, 3), std::vector<uint8_t>({KC_A}));
+    EXPECT_EQ(play(driver, 10), std::vector<uint8_t>({KC_C}));
+    EXPECT_EQ(play(driver, 11), std::vector<uint8_t>({KC_C, KC_A}));
+}
+
+TEST_F(DynamicMacro, SavedMacrosAreLoadedAfterAReboot) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    record(0, {5, 6});
+    record(1, {7});
+    record(9, {6, 7, 5});
+    dynamic_macro_reboot();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(play(driver, 3), std::vector<uint8_t>({KC_A, KC_B}));
+    EXPECT_EQ(play(driver, 4), std::vector<uint8_t>({KC_C}));
+    EXPECT_EQ(play(driver, 11), std::vector<uint8_t>({KC_B, KC_C, KC_A}));
+}
+
+TEST_F(DynamicMacro, CorruptSavedMacrosAreNotLoaded) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    record(0, {5, 6});
+    // A used length larger than the buffer can't be right
+    eeprom_update_word((uint16_t *)(DYNAMIC_MACRO_EEPROM_ADDR + 2), DYNAMIC_MACRO_SIZE + 1);
+    dynamic_macro_reboot();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(play(driver, 3), std::vector<uint8_t>());
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    record(0, {5, 6});
+    // Neither is a header from another number of slots
+    eeprom_update_word((uint16_t *)DYNAMIC_MACRO_EEPROM_ADDR, 0xD700 + DYNAMIC_MACRO_SLOTS + 1);
+    dynamic_macro_reboot();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(play(driver, 3), std::vector<uint8_t>());
+}
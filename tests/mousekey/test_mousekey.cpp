@@ -0,0 +1,120 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "mousekey.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+class MouseKey : public TestFixture {
+protected:
+    ~MouseKey() {
+        mk_max_speed = MOUSEKEY_MAX_SPEED;
+    }
+
+    // Presses the keys and gets past the first step and MOUSEKEY_DELAY
+    void start(TestDriver& driver, std::initializer_list<uint8_t> cols) {
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber());
+        for (uint8_t col : cols) {
+            press_key(col, 0);
+            run_one_scan_loop();
+        }
+        idle_for(MOUSEKEY_DELAY + 1);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+
+    // The reports sent during the given time
+    std::vector<report_mouse_t> run_for(TestDriver& driver, unsigned ms) {
+        std::vector<report_mouse_t> reports;
+        EXPECT_CALL(driver, send_mouse_mock(_)).WillRepeatedly(Invoke([&reports](report_mouse_t& report) {
+            reports.push_back(report);
+        }));
+        idle_for(ms);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        return reports;
+    }
+
+    void stop(TestDriver& driver) {
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber());
+        clear_all_keys();
+        idle_for(MOUSEKEY_REPORT_INTERVAL);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+};
+
+TEST_F(MouseKey, SlowSpeedsCarryTheFractionsOver) {
+    TestDriver driver;
+    // A steady MOUSEKEY_MOVE_DELTA per MOUSEKEY_INTERVAL, 0.1 units per ms
+    mk_max_speed = 1;
+    start(driver, {0});
+    std::vector<report_mouse_t> reports = run_for(driver, 1000);
+    // Each report interval is just short of a unit, so none is sent
+    // unless the carried fractions add up to one
+    int total = 0;
+    for (const report_mouse_t& report : reports) {
+        EXPECT_EQ(report.x, 1);
+        EXPECT_EQ(report.y, 0);
+        total += report.x;
+    }
+    // 1000 ms of 25/256 units per ms, rounded down once, not per report
+    EXPECT_EQ(total, 25 * 1000 / 256);
+    stop(driver);
+}
+
+TEST_F(MouseKey, SpeedRampsUpToTheMaximum) {
+    TestDriver driver;
+    start(driver, {0});
+    // The distance covered in each tenth of the MOUSEKEY_TIME_TO_MAX
+    // intervals keeps growing
+    unsigned tenth = MOUSEKEY_TIME_TO_MAX * MOUSEKEY_INTERVAL / 10;
+    int last = 0;
+    for (int i = 0; i < 10; i++) {
+        int distance = 0;
+        for (const report_mouse_t& report : run_for(driver, tenth)) {
+            distance += report.x;
+        }
+        EXPECT_GT(distance, last);
+        last = distance;
+    }
+    // At the maximum speed of 1000 units per s that is exactly ten units
+    // per report
+    std::vector<report_mouse_t> steady = run_for(driver, 100);
+    EXPECT_EQ(steady.size(), 100 / MOUSEKEY_REPORT_INTERVAL);
+    for (const report_mouse_t& report : steady) {
+        EXPECT_EQ(report.x, MOUSEKEY_MOVE_DELTA * MOUSEKEY_MAX_SPEED * MOUSEKEY_REPORT_INTERVAL / MOUSEKEY_INTERVAL);
+    }
+    stop(driver);
+}
+
+TEST_F(MouseKey, DiagonalMotionKeepsTheFractionsOfBothAxes) {
+    TestDriver driver;
+    mk_max_speed = 1;
+    start(driver, {0, 1});
+    std::vector<report_mouse_t> reports = run_for(driver, 1000);
+    int total_x = 0;
+    int total_y = 0;
+    for (const report_mouse_t& report : reports) {
+        EXPECT_EQ(report.x, report.y);
+        total_x += report.x;
+        total_y += report.y;
+    }
+    // 1/sqrt(2) of the straight speed: 100 * 181 / 256 units per s
+    EXPECT_EQ(total_x, (100 * 181 / 256) * 32 / 125 * 1000 / 256);
+    EXPECT_EQ(total_y, total_x);
+    stop(driver);
+}
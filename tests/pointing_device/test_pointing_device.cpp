@@ -0,0 +1,97 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "pointing_device.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+class PointingDevice : public TestFixture {
+protected:
+    // The reports sent during the given number of scans, with the motion
+    // added before each of them
+    std::vector<report_mouse_t> scan(TestDriver& driver, unsigned scans, int16_t x, int16_t v) {
+        std::vector<report_mouse_t> reports;
+        EXPECT_CALL(driver, send_mouse_mock(_)).WillRepeatedly(Invoke([&reports](report_mouse_t& report) {
+            reports.push_back(report);
+        }));
+        for (unsigned i = 0; i < scans; i++) {
+            pointing_device_add_motion(x, 0, v, 0);
+            run_one_scan_loop();
+        }
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        return reports;
+    }
+
+    static int total_x(const std::vector<report_mouse_t>& reports) {
+        int total = 0;
+        for (const report_mouse_t& report : reports) total += report.x;
+        return total;
+    }
+
+    static int total_v(const std::vector<report_mouse_t>& reports) {
+        int total = 0;
+        for (const report_mouse_t& report : reports) total += report.v;
+        return total;
+    }
+};
+
+TEST_F(PointingDevice, MotionIsSentOncePerReportInterval) {
+    TestDriver driver;
+    std::vector<report_mouse_t> reports = scan(driver, 100, 1, 0);
+    EXPECT_LE(reports.size(), 100 / POINTING_DEVICE_REPORT_INTERVAL + 1);
+    // What is left goes out with the next report
+    std::vector<report_mouse_t> rest = scan(driver, POINTING_DEVICE_REPORT_INTERVAL, 0, 0);
+    EXPECT_EQ(total_x(reports) + total_x(rest), 100);
+}
+
+TEST_F(PointingDevice, LargeMotionIsSplitAcrossReports) {
+    TestDriver driver;
+    idle_for(POINTING_DEVICE_REPORT_INTERVAL);
+    pointing_device_add_motion(300, 0, 0, 0);
+    std::vector<report_mouse_t> reports = scan(driver, 3 * POINTING_DEVICE_REPORT_INTERVAL, 0, 0);
+    ASSERT_EQ(reports.size(), 3);
+    EXPECT_EQ(reports[0].x, 127);
+    EXPECT_EQ(reports[1].x, 127);
+    EXPECT_EQ(reports[2].x, 46);
+}
+
+TEST_F(PointingDevice, WheelFractionsAddUpToWholeSteps) {
+    TestDriver driver;
+    // 10 * 3 eighths: three steps, six eighths left over
+    std::vector<report_mouse_t> added = scan(driver, 10, 0, 3);
+    std::vector<report_mouse_t> drained = scan(driver, 2 * POINTING_DEVICE_REPORT_INTERVAL, 0, 0);
+    EXPECT_EQ(total_v(added) + total_v(drained), 3);
+    // two more eighths complete the fourth step
+    added = scan(driver, 1, 0, 2);
+    drained = scan(driver, POINTING_DEVICE_REPORT_INTERVAL, 0, 0);
+    EXPECT_EQ(total_v(added) + total_v(drained), 1);
+}
+
+TEST_F(PointingDevice, WheelFractionsInBothDirectionsCancelOut) {
+    TestDriver driver;
+    // -9 eighths: one step down, one eighth down left over
+    std::vector<report_mouse_t> added = scan(driver, 1, 0, -9);
+    std::vector<report_mouse_t> drained = scan(driver, POINTING_DEVICE_REPORT_INTERVAL, 0, 0);
+    EXPECT_EQ(total_v(added) + total_v(drained), -1);
+    // one eighth up cancels it, so nothing is sent
+    added = scan(driver, 1, 0, 1);
+    drained = scan(driver, POINTING_DEVICE_REPORT_INTERVAL, 0, 0);
+    EXPECT_TRUE(added.empty());
+    EXPECT_TRUE(drained.empty());
+}
@@ -0,0 +1,70 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "protocol/ps2_mouse_packet.h"
+
+static ps2_mouse_packet_t packet(uint8_t buttons, int16_t x) {
+    ps2_mouse_packet_t p = {};
+    p.buttons = buttons;
+    p.x = x;
+    return p;
+}
+
+// Runs first: the queue is a static with no reset
+TEST(Ps2MousePacket, PacketsWithDifferentButtonsAreNeverMerged) {
+    ps2_mouse_packet_t p;
+    // The queue holds one packet less than its size
+    for (uint8_t i = 0; i < PS2_MOUSE_PACKET_QUEUE_SIZE - 1; i++) {
+        p = packet(i & 1, i + 1);
+        EXPECT_TRUE(ps2_mouse_packet_put(&p));
+    }
+    // Full: the button change is dropped and counted, not merged
+    p = packet((1<<PS2_MOUSE_BTN_RIGHT), 100);
+    EXPECT_FALSE(ps2_mouse_packet_put(&p));
+    EXPECT_EQ(ps2_mouse_packet_dropped(), 1);
+    // Still full, but motion with the newest buttons is merged
+    p = packet((PS2_MOUSE_PACKET_QUEUE_SIZE - 2) & 1, 10);
+    EXPECT_TRUE(ps2_mouse_packet_put(&p));
+
+    for (uint8_t i = 0; i < PS2_MOUSE_PACKET_QUEUE_SIZE - 1; i++) {
+        ASSERT_TRUE(ps2_mouse_packet_get(&p));
+        EXPECT_EQ(p.buttons, i & 1);
+        EXPECT_EQ(p.x, i + 1 + (i == PS2_MOUSE_PACKET_QUEUE_SIZE - 2 ? 10 : 0));
+    }
+    EXPECT_FALSE(ps2_mouse_packet_get(&p));
+}
+
+TEST(Ps2MousePacket, MotionWithTheSameButtonsIsMerged) {
+    ps2_mouse_packet_t p = packet((1<<PS2_MOUSE_BTN_LEFT), 200);
+    EXPECT_TRUE(ps2_mouse_packet_put(&p));
+    p = packet((1<<PS2_MOUSE_BTN_LEFT), 200);
+    p.y = -5;
+    p.v = 1;
+    EXPECT_TRUE(ps2_mouse_packet_put(&p));
+    p = packet(0, 1);
+    EXPECT_TRUE(ps2_mouse_packet_put(&p));
+
+    ASSERT_TRUE(ps2_mouse_packet_get(&p));
+    EXPECT_EQ(p.buttons, (1<<PS2_MOUSE_BTN_LEFT));
+    EXPECT_EQ(p.x, 400);
+    EXPECT_EQ(p.y, -5);
+    EXPECT_EQ(p.v, 1);
+    ASSERT_TRUE(ps2_mouse_packet_get(&p));
+    EXPECT_EQ(p.buttons, 0);
+    EXPECT_EQ(p.x, 1);
+    EXPECT_FALSE(ps2_mouse_packet_get(&p));
+}
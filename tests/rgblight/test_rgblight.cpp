@@ -0,0 +1,287 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+extern "C" {
+#include "rgblight.h"
+#include "led_tables.h"
+void advance_time(uint32_t ms);
+extern rgblight_config_t rgblight_config;
+extern LED_TYPE led[RGBLED_NUM];
+}
+#include "test_common.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <dlfcn.h>
+#include <functional>
+#include <set>
+
+// The effects are integer only, these check them against the floating
+// point and division based code they replaced.
+
+static LED_TYPE shown[RGBLED_NUM];
+static uint32_t frames_sent;
+static uint16_t leds_sent;
+static uint32_t set_calls;
+
+// RGBLIGHT_CUSTOM_DRIVER, a strip that keeps the LEDs it isn't sent
+extern "C" void rgblight_set(void) {
+    set_calls++;
+    uint16_t count = rgblight_take_frame();
+    if (count > 0) {
+        memcpy(shown, led, count * sizeof(LED_TYPE));
+        frames_sent++;
+        leds_sent = count;
+    }
+}
+
+// The math library functions the effects used to call, counted and
+// passed on to the real ones. These definitions take the place of the
+// library's for rgblight.c too.
+static uint32_t libm_calls;
+
+#define COUNT_LIBM_CALLS(type, name) \
+    extern "C" type name(type x) { \
+        static type (*real)(type) = (type (*)(type))dlsym(RTLD_NEXT, #name); \
+        libm_calls++; \
+        return real(x); \
+    }
+#define COUNT_LIBM_CALLS2(type, name) \
+    extern "C" type name(type x, type y) { \
+        static type (*real)(type, type) = (type (*)(type, type))dlsym(RTLD_NEXT, #name); \
+        libm_calls++; \
+        return real(x, y); \
+    }
+
+COUNT_LIBM_CALLS(double, exp)
+COUNT_LIBM_CALLS(float, expf)
+COUNT_LIBM_CALLS(double, sin)
+COUNT_LIBM_CALLS(float, sinf)
+COUNT_LIBM_CALLS(double, cos)
+COUNT_LIBM_CALLS(float, cosf)
+COUNT_LIBM_CALLS(double, log)
+COUNT_LIBM_CALLS(float, logf)
+COUNT_LIBM_CALLS(double, sqrt)
+COUNT_LIBM_CALLS(float, sqrtf)
+COUNT_LIBM_CALLS2(double, pow)
+COUNT_LIBM_CALLS2(float, powf)
+COUNT_LIBM_CALLS2(double, fmod)
+COUNT_LIBM_CALLS2(float, fmodf)
+
+class Rgblight : public testing::Test {
+public:
+    Rgblight() {
+        rgblight_config.enable = 1;
+        rgblight_config.mode = 1;
+        rgblight_config.hue = 0;
+        rgblight_config.sat = 0;
+        rgblight_config.val = 255;
+    }
+
+    // Runs one step of an effect, letting enough time pass first
+    void step(std::function<void()> effect) {
+        advance_time(1000);
+        effect();
+    }
+};
+
+// What sethsv did before, with a division and a modulo
+static void sethsv_divide(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
+    uint8_t r = 0, g = 0, b = 0, base, color;
+    if (sat == 0) {
+        r = g = b = val;
+    } else {
+        base = ((255 - sat) * val) >> 8;
+        color = (val - base) * (hue % 60) / 60;
+        switch (hue / 60) {
+            case 0: r = val; g = base + color; b = base; break;
+            case 1: r = val - color; g = val; b = base; break;
+            case 2: r = base; g = val; b = base + color; break;
+            case 3: r = base; g = val - color; b = val; break;
+            case 4: r = base + color; g = base; b = val; break;
+            case 5: r = val; g = base; b = val - color; break;
+        }
+    }
+    led1->r = pgm_read_byte(&CIE1931_CURVE[r]);
+    led1->g = pgm_read_byte(&CIE1931_CURVE[g]);
+    led1->b = pgm_read_byte(&CIE1931_CURVE[b]);
+}
+
+TEST_F(Rgblight, sethsv_matches_division) {
+    for (uint16_t hue = 0; hue < 360; hue++) {
+        for (uint16_t sat = 1; sat < 256; sat++) {
+            for (uint16_t val = 0; val < 256; val++) {
+                LED_TYPE expected, actual;
+                sethsv_divide(hue, sat, val, &expected);
+                sethsv(hue, sat, val, &actual);
+                ASSERT_EQ(actual.r, expected.r) << hue << " " << sat << " " << val;
+                ASSERT_EQ(actual.g, expected.g) << hue << " " << sat << " " << val;
+                ASSERT_EQ(actual.b, expected.b) << hue << " " << sat << " " << val;
+            }
+        }
+    }
+}
+
+TEST_F(Rgblight, breathing_follows_the_floating_point_curve) {
+    uint8_t seen[256];
+    for (int i = 0; i < 256; i++) {
+        step([] { rgblight_effect_breathing(0); });
+        seen[i] = shown[0].r;
+    }
+    // The effect may be anywhere in its cycle, find where it started
+    int best_errors = 256;
+    for (int start = 0; start < 256; start++) {
+        int errors = 0;
+        for (int i = 0; i < 256; i++) {
+            uint8_t pos = start + i;
+            double ref = (exp(sin((pos / 255.0) * M_PI)) - RGBLIGHT_EFFECT_BREATHE_CENTER / M_E) *
+                (RGBLIGHT_EFFECT_BREATHE_MAX / (M_E - 1 / M_E));
+            uint8_t val = ref;
+            uint8_t low = pgm_read_byte(&CIE1931_CURVE[val > 0 ? val - 1 : 0]);
+            uint8_t high = pgm_read_byte(&CIE1931_CURVE[val < 255 ? val + 1 : 255]);
+            if (seen[i] < low || seen[i] > high) {
+                errors++;
+            }
+        }
+        best_errors = std::min(best_errors, errors);
+    }
+    EXPECT_EQ(best_errors, 0);
+}
+
+// The hues where the LEDs look like the old swirl with the given hue
+static std::set<int> swirl_hues() {
+    std::set<int> hues;
+    for (int hue = 0; hue < 360; hue++) {
+        bool same = true;
+        for (int j = 0; j < RGBLED_NUM; j++) {
+            LED_TYPE expected;
+            sethsv_divide((360 / RGBLED_NUM * j + hue) % 360, 255, 255, &expected);
+            same &= shown[j].r == expected.r && shown[j].g == expected.g && shown[j].b == expected.b;
+        }
+        if (same) {
+            hues.insert(hue);
+        }
+    }
+    return hues;
+}
+
+TEST_F(Rgblight, rainbow_swirl_matches_modulo) {
+    rgblight_config.sat = 255;
+    for (uint8_t interval : {0, 1}) {
+        step([=] { rgblight_effect_rainbow_swirl(interval); });
+        std::set<int> hues = swirl_hues();
+        ASSERT_FALSE(hues.empty());
+        for (int i = 0; i < 400; i++) {
+            step([=] { rgblight_effect_rainbow_swirl(interval); });
+            std::set<int> moved;
+            for (int hue : swirl_hues()) {
+                if (hues.count((interval & 1 ? hue + 359 : hue + 1) % 360)) {
+                    moved.insert(hue);
+                }
+            }
+            ASSERT_FALSE(moved.empty()) << "step " << i;
+            hues = moved;
+        }
+    }
+}
+
+TEST_F(Rgblight, christmas_alternates_red_and_green) {
+    rgblight_config.sat = 255;
+    for (int i = 0; i < 4; i++) {
+        step([] { rgblight_effect_christmas(); });
+        bool first_green = shown[0].g > shown[0].r;
+        for (int j = 0; j < RGBLED_NUM; j++) {
+            bool green = first_green != ((j / RGBLIGHT_EFFECT_CHRISTMAS_STEP) % 2);
+            EXPECT_EQ(shown[j].g > shown[j].r, green) << j;
+        }
+        LED_TYPE first = shown[0];
+        step([] { rgblight_effect_christmas(); });
+        EXPECT_NE(shown[0].g > shown[0].r, first.g > first.r);
+    }
+}
+
+// Every step of an effect computes the LEDs once, without the math
+// library, and hands them to rgblight_set() once. The time taken on
+// the host is only printed, it says nothing about the AVR and is too
+// noisy to test against.
+TEST_F(Rgblight, effects_set_the_leds_once_per_step) {
+    rgblight_config.sat = 200;
+    rgblight_config.val = 200;
+    std::pair<const char*, std::function<void()>> effects[] = {
+        {"breathing", [] { rgblight_effect_breathing(3); }},
+        {"rainbow mood", [] { rgblight_effect_rainbow_mood(2); }},
+        {"rainbow swirl", [] { rgblight_effect_rainbow_swirl(5); }},
+        {"snake", [] { rgblight_effect_snake(5); }},
+        {"knight", [] { rgblight_effect_knight(2); }},
+        {"christmas", [] { rgblight_effect_christmas(); }},
+    };
+    const int steps = 20000;
+    for (auto& effect : effects) {
+        set_calls = 0;
+        libm_calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; i++) {
+            // one more, TIMER_DIFF_16 comes out a millisecond short
+            // when the timer wraps
+            advance_time(RGBLIGHT_EFFECT_CHRISTMAS_INTERVAL + 1);
+            effect.second();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        printf("%-14s %6.0f ns per step\n", effect.first, elapsed.count() / steps);
+        EXPECT_EQ(set_calls, (uint32_t)steps) << effect.first;
+        EXPECT_EQ(libm_calls, 0u) << effect.first;
+    }
+}
+
+TEST_F(Rgblight, unchanged_frame_is_not_sent) {
+    advance_time(1000);
+    rgblight_setrgb(1, 2, 3);
+    uint32_t frames = frames_sent;
+    advance_time(1000);
+    rgblight_setrgb(1, 2, 3);
+    EXPECT_EQ(frames_sent, frames);
+    for (int j = 0; j < RGBLED_NUM; j++) {
+        EXPECT_EQ(shown[j].r, 1);
+    }
+}
+
+TEST_F(Rgblight, only_leds_up_to_the_last_change_are_sent) {
+    advance_time(1000);
+    rgblight_setrgb(1, 2, 3);
+    advance_time(1000);
+    rgblight_setrgb_at(4, 5, 6, 2);
+    EXPECT_EQ(leds_sent, 3);
+    EXPECT_EQ(shown[2].r, 4);
+    EXPECT_EQ(shown[RGBLED_NUM - 1].r, 1);
+}
+
+TEST_F(Rgblight, frames_over_the_fps_limit_are_sent_later) {
+    advance_time(1000);
+    rgblight_setrgb(10, 10, 10);
+    uint32_t frames = frames_sent;
+    rgblight_setrgb(20, 20, 20);
+    EXPECT_EQ(frames_sent, frames);
+    EXPECT_EQ(shown[0].r, 10);
+    advance_time(1000 / RGBLIGHT_MAX_FPS - 1);
+    rgblight_task();
+    EXPECT_EQ(frames_sent, frames);
+    advance_time(1);
+    rgblight_task();
+    EXPECT_EQ(frames_sent, frames + 1);
+    EXPECT_EQ(shown[0].r, 20);
+    rgblight_task();
+    EXPECT_EQ(frames_sent, frames + 1);
+}
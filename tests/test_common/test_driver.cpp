@@ -55,3 +55,7 @@ void TestDriver::send_system(uint16_t data) {
 void TestDriver::send_consumer(uint16_t data) {
     m_this->send_consumer(data);
 }
+
+bool host_keyboard_ready(void) {
+    return !TestDriver::m_this || TestDriver::m_this->m_ready;
+}
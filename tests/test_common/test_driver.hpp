@@ -28,6 +28,8 @@ public:
     TestDriver();
     ~TestDriver();
     void set_leds(uint8_t leds) { m_leds = leds; }
+    // false makes host_keyboard_ready() report reports waiting for the host
+    void set_ready(bool ready) { m_ready = ready; }
     
     MOCK_METHOD1(send_keyboard_mock, void (report_keyboard_t&));
     MOCK_METHOD1(send_mouse_mock, void (report_mouse_t&));
@@ -41,7 +43,9 @@ private:
     static void send_consumer(uint16_t data);
     host_driver_t m_driver;
     uint8_t m_leds = 0;
+    bool m_ready = true;
     static TestDriver* m_this;
+    friend bool ::host_keyboard_ready(void);
 };
 
 
@@ -0,0 +1,35 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        // 0       1        2     3
+        {UC(0xE9), KC_LSFT, KC_A, KC_NO},
+    },
+};
+
+// Sorted by name, so lookups use a binary search
+const qk_ucis_symbol_t ucis_symbol_table[] = UCIS_TABLE
+(
+    UCIS_SYM("bolt", 0x26a1),
+    UCIS_SYM("coffee", 0x2615),
+    UCIS_SYM("heart", 0x2764),
+    UCIS_SYM("pi", 0x03c0),
+    UCIS_SYM("poop", 0x1f4a9),
+    UCIS_SYM("poop2", 0x1f4a9)
+);
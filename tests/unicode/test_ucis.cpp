@@ -0,0 +1,88 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+
+class Ucis : public TestFixture {
+public:
+    void type(uint16_t keycode) {
+        keyrecord_t record = {};
+        record.event.pressed = true;
+        process_ucis(keycode, &record);
+    }
+};
+
+TEST_F(Ucis, CompletionsNarrowAsTheNameIsTyped) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    qk_ucis_start();
+    const qk_ucis_symbol_t *first;
+
+    type(KC_P);
+    EXPECT_EQ(qk_ucis_completions(&first), 3);
+    EXPECT_STREQ(first->symbol, "pi");
+
+    type(KC_O);
+    EXPECT_EQ(qk_ucis_completions(&first), 2);
+    EXPECT_STREQ(first->symbol, "poop");
+
+    type(KC_O);
+    type(KC_P);
+    type(KC_2);
+    EXPECT_EQ(qk_ucis_completions(&first), 1);
+    EXPECT_STREQ(first->symbol, "poop2");
+
+    type(KC_X);
+    EXPECT_EQ(qk_ucis_completions(&first), 0);
+    EXPECT_EQ(first, nullptr);
+
+    type(KC_ESC);
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+}
+
+TEST_F(Ucis, KnownSymbolIsTyped) {
+    TestDriver driver;
+    set_unicode_input_mode(UC_LNX);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    qk_ucis_start();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    type(KC_P);
+    type(KC_I);
+    // Erasing the two letters and the space, then the sequence for U+03C0
+    testing::InSequence s;
+    for (int i = 0; i < 3; i++) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_BSPC)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL))).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT, KC_U)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    for (uint8_t key : {KC_0, KC_3, KC_C, KC_0}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_SPC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    type(KC_SPC);
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+}
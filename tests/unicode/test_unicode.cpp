@@ -0,0 +1,156 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+class Unicode : public TestFixture {};
+
+TEST_F(Unicode, OsxCodePointIsStreamedOneReportPerScan) {
+    TestDriver driver;
+    InSequence s;
+    set_unicode_input_mode(UC_OSX);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    run_one_scan_loop();
+    // Nothing is sent while waiting for the input method
+    idle_for(UNICODE_TYPE_DELAY);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_0)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_0)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_9)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    // The finish hook gets a scan of its own
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(10);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_FALSE(unicode_busy());
+    release_key(0, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(Unicode, OsxBatchesConsecutiveCodePointsInOneSession) {
+    TestDriver driver;
+    InSequence s;
+    set_unicode_input_mode(UC_OSX);
+    send_unicode_string("\xC3\xA9\xF0\x9F\x98\x80");
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    idle_for(1 + UNICODE_TYPE_DELAY);
+    // U+00E9, then U+1F600 as the surrogate pair D83D DE00, all with Alt held
+    for (uint8_t key : {KC_0, KC_0, KC_E, KC_9, KC_D, KC_8, KC_3, KC_D, KC_D, KC_E, KC_0, KC_0}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport((uint8_t)KC_LALT, key)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(26);
+    EXPECT_FALSE(unicode_busy());
+}
+
+TEST_F(Unicode, LinuxUsesOneSessionPerCodePoint) {
+    TestDriver driver;
+    InSequence s;
+    set_unicode_input_mode(UC_LNX);
+    send_unicode_codepoint(0x2328);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT, KC_U)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(2 + UNICODE_TYPE_DELAY);
+    for (uint8_t key : {KC_2, KC_3, KC_2, KC_8}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_SPC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(11);
+    EXPECT_FALSE(unicode_busy());
+}
+
+TEST_F(Unicode, ModifierReleasedDuringOutputIsNotRestored) {
+    TestDriver driver;
+    InSequence s;
+    set_unicode_input_mode(UC_OSX);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    send_unicode_codepoint(0xE9);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    idle_for(30);
+    EXPECT_FALSE(unicode_busy());
+    EXPECT_EQ(get_mods(), 0);
+}
+
+TEST_F(Unicode, KeysPressedDuringOutputWaitForIt) {
+    TestDriver driver;
+    InSequence s;
+    set_unicode_input_mode(UC_LNX);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    // A goes down while U+00E9 is being typed, it must not end up in the
+    // hex digits
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT, KC_U)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    for (uint8_t key : {KC_0, KC_0, KC_E, KC_9}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_SPC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    idle_for(40);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_FALSE(unicode_busy());
+    release_key(0, 0);
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    run_one_scan_loop();
+}
+
+TEST_F(Unicode, FullQueueHandsBackTheRestOfTheString) {
+    TestDriver driver;
+    set_unicode_input_mode(UC_OSX);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    char str[UNICODE_QUEUE_SIZE + 3] = {};
+    memset(str, 'a', UNICODE_QUEUE_SIZE);
+    str[UNICODE_QUEUE_SIZE] = 'b';
+    str[UNICODE_QUEUE_SIZE + 1] = 'c';
+    const char *rest = send_unicode_string(str);
+    EXPECT_EQ(rest, str + UNICODE_QUEUE_SIZE);
+    EXPECT_FALSE(send_unicode_codepoint('x'));
+    // The queue drains from the scan loop, not from the caller
+    for (int i = 0; i < 50 && rest; i++) {
+        run_one_scan_loop();
+        rest = send_unicode_string(rest);
+    }
+    EXPECT_EQ(rest, nullptr);
+    idle_for(200);
+    EXPECT_FALSE(unicode_busy());
+}
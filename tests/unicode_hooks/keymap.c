@@ -0,0 +1,39 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {UC(0xE9)},
+    },
+};
+
+// Session hooks the way keymaps override them: typed right away, without
+// a delay of their own
+void unicode_input_start(void) {
+  register_code(KC_LCTL);
+  register_code(KC_LSFT);
+  register_code(KC_U);
+  unregister_code(KC_U);
+  unregister_code(KC_LSFT);
+  unregister_code(KC_LCTL);
+}
+
+void unicode_input_finish(void) {
+  register_code(KC_ENT);
+  unregister_code(KC_ENT);
+}
@@ -0,0 +1,60 @@
+/* Copyright 2026 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class UnicodeHooks : public TestFixture {};
+
+TEST_F(UnicodeHooks, OverriddenHooksTypeWhereTheSessionStartsAndEnds) {
+    TestDriver driver;
+    InSequence s;
+    set_unicode_input_mode(UC_LNX);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT, KC_U)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // The start override doesn't wait, the stream still does
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(UNICODE_TYPE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // The finish override types after the hex digits, not before them
+    for (uint8_t key : {KC_0, KC_0, KC_E, KC_9}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ENT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(20);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_FALSE(unicode_busy());
+    release_key(0, 0);
+    run_one_scan_loop();
+}
@@ -14,10 +14,13 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <stddef.h>
 #include "action.h"
 #include "action_util.h"
 #include "action_macro.h"
+#include "host.h"
 #include "wait.h"
+#include "timer.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -28,58 +31,124 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #ifndef NO_ACTION_MACRO
 
+/* Macros are played from action_macro_task() so that the WAIT and
+ * INTERVAL commands don't block the keyboard. action_macro_play() only
+ * queues the macro and runs it up to its first delay, or until the
+ * reports it sent have to wait for the host (see host_keyboard_ready()).
+ */
+static const macro_t *macro_queue[ACTION_MACRO_QUEUE_SIZE];
+static uint8_t macro_queue_head = 0;
+static uint8_t macro_queue_count = 0;
+
+/* The macro being played, NULL if none */
+static const macro_t *macro_p = NULL;
+static uint8_t interval = 0;
+
+/* Time to wait before the next command */
+static uint16_t delay = 0;
+static uint16_t delay_start = 0;
+
 #define MACRO_READ()  (macro = MACRO_GET(macro_p++))
-void action_macro_play(const macro_t *macro_p)
+/* Execute a single command of the current macro. Returns false at the end of it. */
+static bool action_macro_step(void)
 {
     macro_t macro = END;
-    uint8_t interval = 0;
 
-    if (!macro_p) return;
-    while (true) {
-        switch (MACRO_READ()) {
-            case KEY_DOWN:
-                MACRO_READ();
-                dprintf("KEY_DOWN(%02X)\n", macro);
-                if (IS_MOD(macro)) {
-                    add_macro_mods(MOD_BIT(macro));
-                    send_keyboard_report();
-                } else {
-                    register_code(macro);
-                }
-                break;
-            case KEY_UP:
-                MACRO_READ();
-                dprintf("KEY_UP(%02X)\n", macro);
-                if (IS_MOD(macro)) {
-                    del_macro_mods(MOD_BIT(macro));
-                    send_keyboard_report();
-                } else {
-                    unregister_code(macro);
-                }
-                break;
-            case WAIT:
-                MACRO_READ();
-                dprintf("WAIT(%u)\n", macro);
-                { uint8_t ms = macro; while (ms--) wait_ms(1); }
-                break;
-            case INTERVAL:
-                interval = MACRO_READ();
-                dprintf("INTERVAL(%u)\n", interval);
-                break;
-            case 0x04 ... 0x73:
-                dprintf("DOWN(%02X)\n", macro);
+    switch (MACRO_READ()) {
+        case KEY_DOWN:
+            MACRO_READ();
+            dprintf("KEY_DOWN(%02X)\n", macro);
+            if (IS_MOD(macro)) {
+                add_macro_mods(MOD_BIT(macro));
+                send_keyboard_report();
+            } else {
                 register_code(macro);
-                break;
-            case 0x84 ... 0xF3:
-                dprintf("UP(%02X)\n", macro);
-                unregister_code(macro&0x7F);
-                break;
-            case END:
-            default:
-                return;
+            }
+            break;
+        case KEY_UP:
+            MACRO_READ();
+            dprintf("KEY_UP(%02X)\n", macro);
+            if (IS_MOD(macro)) {
+                del_macro_mods(MOD_BIT(macro));
+                send_keyboard_report();
+            } else {
+                unregister_code(macro);
+            }
+            break;
+        case WAIT:
+            MACRO_READ();
+            dprintf("WAIT(%u)\n", macro);
+            delay = macro;
+            break;
+        case INTERVAL:
+            interval = MACRO_READ();
+            dprintf("INTERVAL(%u)\n", interval);
+            break;
+        case 0x04 ... 0x73:
+            dprintf("DOWN(%02X)\n", macro);
+            register_code(macro);
+            break;
+        case 0x84 ... 0xF3:
+            dprintf("UP(%02X)\n", macro);
+            unregister_code(macro&0x7F);
+            break;
+        case END:
+        default:
+            return false;
+    }
+    // interval
+    delay += interval;
+    if (delay) {
+        delay_start = timer_read();
+    }
+    return true;
+}
+
+void action_macro_task(void)
+{
+    while (true) {
+        if (delay) {
+            if (timer_elapsed(delay_start) < delay) return;
+            delay = 0;
+        }
+        // the reports of the last step are still waiting for the host
+        if (!host_keyboard_ready()) return;
+        if (!macro_p) {
+            if (!macro_queue_count) return;
+            macro_p = macro_queue[macro_queue_head];
+            macro_queue_head = (macro_queue_head + 1) % ACTION_MACRO_QUEUE_SIZE;
+            macro_queue_count--;
+            interval = 0;
+        }
+        if (!action_macro_step()) {
+            macro_p = NULL;
         }
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
     }
 }
+
+bool action_macro_busy(void)
+{
+    return macro_p || macro_queue_count;
+}
+
+bool action_macro_queue_full(void)
+{
+    return macro_queue_count == ACTION_MACRO_QUEUE_SIZE;
+}
+
+void action_macro_play(const macro_t *macro)
+{
+    if (!macro) return;
+
+    // keyboard_task() holds the key events back while the queue is full,
+    // so this only happens when a single event plays several macros
+    if (action_macro_queue_full()) {
+        dprintln("MACRO: queue full, dropped");
+        return;
+    }
+
+    macro_queue[(macro_queue_head + macro_queue_count) % ACTION_MACRO_QUEUE_SIZE] = macro;
+    macro_queue_count++;
+    action_macro_task();
+}
 #endif
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef ACTION_MACRO_H
 #define ACTION_MACRO_H
 #include <stdint.h>
+#include <stdbool.h>
 #include "progmem.h"
 
 
@@ -49,10 +50,33 @@ typedef uint8_t macro_t;
      
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef NO_ACTION_MACRO
+/* Number of macros that can wait for the one being played */
+#ifndef ACTION_MACRO_QUEUE_SIZE
+#define ACTION_MACRO_QUEUE_SIZE 4
+#endif
+
+/* Queue a macro. It starts right away unless another macro is still
+ * playing, and runs up to its first WAIT or INTERVAL delay. */
 void action_macro_play(const macro_t *macro_p);
+/* Advance the macros past their delays; called from keyboard_task() */
+void action_macro_task(void);
+bool action_macro_busy(void);
+/* No room for another macro; keyboard_task() holds key events meanwhile */
+bool action_macro_queue_full(void);
 #else
 #define action_macro_play(macro)
+#define action_macro_task()
+#define action_macro_busy() false
+#define action_macro_queue_full() false
+#endif
+
+#ifdef __cplusplus
+}
 #endif
 
 
@@ -57,6 +57,13 @@ void host_keyboard_send(report_keyboard_t *report)
     }
 }
 
+/* Drivers that queue reports override this */
+__attribute__ ((weak))
+bool host_keyboard_ready(void)
+{
+    return true;
+}
+
 void host_mouse_send(report_mouse_t *report)
 {
     if (!driver) return;
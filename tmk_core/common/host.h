@@ -43,6 +43,11 @@ void host_mouse_send(report_mouse_t *report);
 void host_system_send(uint16_t data);
 void host_consumer_send(uint16_t data);
 
+/* false while keyboard reports are still waiting for the host to poll.
+ * The keyboard code leaves its next event for a later scan until then,
+ * so bursts reach the host without the driver waiting or dropping any. */
+bool host_keyboard_ready(void);
+
 uint16_t host_last_system_report(void);
 uint16_t host_last_consumer_report(void);
 
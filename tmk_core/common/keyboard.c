@@ -66,6 +66,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef POINTING_DEVICE_ENABLE
 #   include "pointing_device.h"
 #endif
+#ifdef SPLIT_EVENTS
+#   include "split_util.h"
+#endif
 
 #ifdef MATRIX_HAS_GHOST
 extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
@@ -127,6 +130,19 @@ bool is_keyboard_master(void) {
     return true;
 }
 
+__attribute__((weak))
+bool keyboard_output_busy(void) {
+    return false;
+}
+
+/* Key events that come in while they are held back, see keyboard_task() */
+#ifndef KEYBOARD_HELD_EVENTS
+#   define KEYBOARD_HELD_EVENTS 8
+#endif
+static keyevent_t held_events[KEYBOARD_HELD_EVENTS];
+static uint8_t held_events_head = 0;
+static uint8_t held_events_count = 0;
+
 void keyboard_init(void) {
     timer_init();
     matrix_init();
@@ -182,6 +198,32 @@ void keyboard_task(void)
 #endif
 
     matrix_scan();
+    // Key events are held back while the reports of the last one are still
+    // waiting for the host, or while output that is typed out over several
+    // scans is in progress, or while the macro queue is full. They are kept
+    // in order and processed once that is done; only when more come in than
+    // held_events takes are they left in the matrix.
+    bool hold = !host_keyboard_ready() || keyboard_output_busy() || action_macro_queue_full();
+    if (!hold && held_events_count) {
+        keyevent_t event = held_events[held_events_head];
+        held_events_head = (held_events_head + 1) % KEYBOARD_HELD_EVENTS;
+        held_events_count--;
+        action_exec(event);
+        goto MATRIX_LOOP_END;
+    }
+    if (hold && held_events_count == KEYBOARD_HELD_EVENTS) {
+        goto MATRIX_LOOP_END;
+    }
+#ifdef SPLIT_EVENTS
+    if (is_keyboard_master()) {
+        // the split matrix hands out the key events of both halves with
+        // the time they happened, in that order, and keeps them meanwhile
+        if (!hold) {
+            action_exec(split_event_next());
+        }
+        goto MATRIX_LOOP_END;
+    }
+#endif
     if (is_keyboard_master()) {
         for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
             matrix_row = matrix_get_row(r);
@@ -204,13 +246,19 @@ void keyboard_task(void)
                 if (debug_matrix) matrix_print();
                 for (uint8_t c = 0; c < MATRIX_COLS; c++) {
                     if (matrix_change & ((matrix_row_t)1<<c)) {
-                        action_exec((keyevent_t){
+                        keyevent_t event = {
                             .key = (keypos_t){ .row = r, .col = c },
                             .pressed = (matrix_row & ((matrix_row_t)1<<c)),
                             .time = (timer_read() | 1) /* time should not be 0 */
-                        });
+                        };
                         // record a processed key
                         matrix_prev[r] ^= ((matrix_row_t)1<<c);
+                        if (hold) {
+                            held_events[(held_events_head + held_events_count) % KEYBOARD_HELD_EVENTS] = event;
+                            held_events_count++;
+                            goto MATRIX_LOOP_END;
+                        }
+                        action_exec(event);
 #ifdef QMK_KEYS_PER_SCAN
                         // only jump out if we have processed "enough" keys.
                         if (++keys_processed >= QMK_KEYS_PER_SCAN)
@@ -227,10 +275,13 @@ void keyboard_task(void)
     // we can get here with some keys processed now.
     if (!keys_processed)
 #endif
-    action_exec(TICK);
+    if (!hold) action_exec(TICK);
 
 MATRIX_LOOP_END:
 
+    // continue the macros waiting for their delays
+    action_macro_task();
+
 #ifdef MOUSEKEY_ENABLE
     // mousekey repeat & acceleration
     mousekey_task();
@@ -65,6 +65,9 @@ void keyboard_init(void);
 void keyboard_task(void);
 /* it runs when host LED status is updated */
 void keyboard_set_leds(uint8_t leds);
+/* true while output typed out over several scans (Unicode strings) must
+ * not be mixed with new key events; they are held back until it is done */
+bool keyboard_output_busy(void);
 
 #ifdef __cplusplus
 }
@@ -46,8 +46,13 @@ uint8_t mk_interval = MOUSEKEY_INTERVAL;
 uint8_t mk_max_speed = MOUSEKEY_MAX_SPEED;
 /* number of events (count) accelerating to steady speed (0-255) */
 uint8_t mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
+#ifdef MOUSEKEY_SMOOTH
+/* ramp used to reach maximum pointer speed: 0 linear, 1 quadratic, 2 cubic */
+uint8_t mk_curve = MOUSEKEY_CURVE;
+#else
 /* ramp used to reach maximum pointer speed (NOT SUPPORTED) */
 //int8_t mk_curve = 0;
+#endif
 /* wheel params */
 uint8_t mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
 uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
@@ -102,6 +107,112 @@ static uint8_t wheel_unit(void)
     return (unit > MOUSEKEY_WHEEL_MAX ? MOUSEKEY_WHEEL_MAX : (unit == 0 ? 1 : unit));
 }
 
+#ifdef MOUSEKEY_SMOOTH
+/*
+ * Smooth motion
+ *
+ * Instead of moving a whole step each mk_interval, the speed (units per
+ * second) is integrated over the real time elapsed since the last report,
+ * in 1/256 unit fixed point. The parts of a unit left over are carried to
+ * the next report, so slow speeds are smooth too and the speed does not
+ * depend on how often mousekey_task() is called.
+ *
+ * The parameters keep their meaning: the pointer starts at
+ * MOUSEKEY_MOVE_DELTA per mk_interval and reaches mk_max_speed times that
+ * after mk_time_to_max intervals, following mk_curve.
+ */
+static uint32_t motion_start = 0;
+static uint32_t motion_last = 0;
+/* sub-unit remainders of x, y, v and h in 1/256 */
+static uint8_t motion_frac[4] = {0};
+
+static uint32_t motion_speed(uint8_t delta, uint8_t max_speed, uint8_t time_to_max, uint32_t held)
+{
+    uint8_t interval = mk_interval ? mk_interval : 1;
+    uint32_t start = (uint32_t)delta * 1000 / interval;
+    uint32_t max = start * (max_speed ? max_speed : 1);
+    uint32_t ramp = (uint32_t)time_to_max * interval;
+
+    if (mousekey_accel & (1<<0)) return max/4;
+    if (mousekey_accel & (1<<1)) return max/2;
+    if (mousekey_accel & (1<<2)) return max;
+    if (held >= ramp) return max;
+
+    // progress along the ramp in 1/256
+    uint32_t t = held * 256 / ramp;
+    uint32_t f = t;
+    for (uint8_t i = 0; i < mk_curve; i++) {
+        f = f * t / 256;
+    }
+    return start + (max - start) * f / 256;
+}
+
+static int8_t motion_step(int8_t dir, uint8_t *frac, uint32_t speed, uint8_t dt, uint8_t max)
+{
+    if (!dir) {
+        *frac = 0;
+        return 0;
+    }
+
+    // speed * 256 / 1000: 1/256 units per millisecond
+    uint32_t step = speed * 32 / 125;
+    if (step > ((uint32_t)max << 8)) step = (uint32_t)max << 8;
+
+    uint32_t dist = *frac + step * dt;
+    uint8_t units;
+    if ((dist >> 8) >= max) {
+        // drop what does not fit in a report rather than lag behind
+        units = max;
+        *frac = 0;
+    } else {
+        units = dist >> 8;
+        *frac = dist & 0xFF;
+    }
+    return dir > 0 ? units : -units;
+}
+
+void mousekey_task(void)
+{
+    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
+        return;
+
+    /* the first step is sent by the key press, the motion starts after mk_delay */
+    if (mousekey_repeat == 0) {
+        if (timer_elapsed(last_timer) < mk_delay*10)
+            return;
+        mousekey_repeat = 1;
+        motion_start = motion_last = timer_read32();
+        for (uint8_t i = 0; i < 4; i++) motion_frac[i] = 0;
+        return;
+    }
+
+    uint32_t now = timer_read32();
+    uint32_t dt = now - motion_last;
+    if (dt < MOUSEKEY_REPORT_INTERVAL)
+        return;
+    motion_last = now;
+    // don't jump after a stall
+    if (dt > 100) dt = 100;
+
+    uint32_t held = now - motion_start;
+    uint32_t move = motion_speed(MOUSEKEY_MOVE_DELTA, mk_max_speed, mk_time_to_max, held);
+    uint32_t wheel = motion_speed(MOUSEKEY_WHEEL_DELTA, mk_wheel_max_speed, mk_wheel_time_to_max, held);
+
+    /* diagonal move [1/sqrt(2)] */
+    if (mouse_report.x && mouse_report.y)
+        move = move * 181 / 256;
+
+    report_mouse_t report = mouse_report;
+    report.x = motion_step(mouse_report.x, &motion_frac[0], move, dt, MOUSEKEY_MOVE_MAX);
+    report.y = motion_step(mouse_report.y, &motion_frac[1], move, dt, MOUSEKEY_MOVE_MAX);
+    report.v = motion_step(mouse_report.v, &motion_frac[2], wheel, dt, MOUSEKEY_WHEEL_MAX);
+    report.h = motion_step(mouse_report.h, &motion_frac[3], wheel, dt, MOUSEKEY_WHEEL_MAX);
+
+    if (report.x || report.y || report.v || report.h) {
+        host_mouse_send(&report);
+    }
+}
+#else
 void mousekey_task(void)
 {
     if (timer_elapsed(last_timer) < (mousekey_repeat ? mk_interval : mk_delay*10))
@@ -132,6 +243,7 @@ void mousekey_task(void)
 
     mousekey_send();
 }
+#endif
 
 void mousekey_on(uint8_t code)
 {
@@ -179,6 +291,15 @@ void mousekey_off(uint8_t code)
 void mousekey_send(void)
 {
     mousekey_debug();
+#ifdef MOUSEKEY_SMOOTH
+    /* once moving, the motion comes from mousekey_task() only */
+    if (mousekey_repeat) {
+        report_mouse_t report = { .buttons = mouse_report.buttons };
+        host_mouse_send(&report);
+        last_timer = timer_read();
+        return;
+    }
+#endif
     host_mouse_send(&mouse_report);
     last_timer = timer_read();
 }
@@ -59,6 +59,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MOUSEKEY_WHEEL_TIME_TO_MAX
 #define MOUSEKEY_WHEEL_TIME_TO_MAX 40
 #endif
+#ifndef MOUSEKEY_CURVE
+#define MOUSEKEY_CURVE 0
+#endif
+/* milliseconds between reports with MOUSEKEY_SMOOTH, best matched to the USB polling interval */
+#ifndef MOUSEKEY_REPORT_INTERVAL
+#   if defined(__AVR__)
+#       define MOUSEKEY_REPORT_INTERVAL 10
+#   else
+#       define MOUSEKEY_REPORT_INTERVAL 1
+#   endif
+#endif
 
 
 #ifdef __cplusplus
@@ -71,6 +82,9 @@ extern uint8_t mk_max_speed;
 extern uint8_t mk_time_to_max;
 extern uint8_t mk_wheel_max_speed;
 extern uint8_t mk_wheel_time_to_max;
+#ifdef MOUSEKEY_SMOOTH
+extern uint8_t mk_curve;
+#endif
 
 
 void mousekey_task(void);
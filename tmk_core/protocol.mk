@@ -3,6 +3,7 @@ PROTOCOL_DIR = protocol
 
 ifdef PS2_MOUSE_ENABLE
     SRC += $(PROTOCOL_DIR)/ps2_mouse.c
+    SRC += $(PROTOCOL_DIR)/ps2_mouse_packet.c
     OPT_DEFS += -DPS2_MOUSE_ENABLE
     OPT_DEFS += -DMOUSE_ENABLE
 endif
@@ -46,6 +47,10 @@ ifdef SERIAL_MOUSE_USE_UART
     SRC += $(PROTOCOL_DIR)/serial_uart.c
 endif
 
+ifeq ($(strip $(SERIAL_FRAME_ENABLE)), yes)
+    SRC += $(PROTOCOL_DIR)/serial_frame.c
+endif
+
 ifdef ADB_MOUSE_ENABLE
 	 OPT_DEFS += -DADB_MOUSE_ENABLE -DMOUSE_ENABLE
 endif
@@ -181,6 +181,9 @@ int main(void) {
 #endif
     }
 
+#ifdef USB_SOF_SYNC
+    usb_sof_sync_wait();
+#endif /* USB_SOF_SYNC */
     keyboard_task();
   }
 }
@@ -15,6 +15,8 @@
  * GPL v2 or later.
  */
 
+#include <string.h>
+
 #include "ch.h"
 #include "hal.h"
 
@@ -769,6 +771,172 @@ static const USBEndpointConfig nkro_ep_config = {
 };
 #endif /* NKRO_ENABLE */
 
+/* ---------------------------------------------------------
+ *                  Report transmit rings
+ * ---------------------------------------------------------
+ */
+
+/* Reports are pushed into a small ring per endpoint from the main thread.
+ * The first one is started right away; every following one is started
+ * from the endpoint's IN callback when the previous transfer completes,
+ * so the main thread never waits on the host polling the endpoint.
+ *
+ * The keyboard code checks host_keyboard_ready() and leaves its next event
+ * for a later scan while reports are waiting, so a ring only fills up when
+ * one event sends a lot of reports at once. The thread sending a report
+ * into a full ring sleeps until the IN callback frees a slot; reports are
+ * never dropped or replaced.
+ * All fields are accessed with the system locked.
+ */
+#ifndef USB_REPORT_QUEUE_SIZE
+#define USB_REPORT_QUEUE_SIZE 4
+#endif
+
+#if (USB_REPORT_QUEUE_SIZE & (USB_REPORT_QUEUE_SIZE - 1)) != 0 || USB_REPORT_QUEUE_SIZE < 2 || USB_REPORT_QUEUE_SIZE > 128
+#error "USB_REPORT_QUEUE_SIZE must be a power of two between 2 and 128"
+#endif
+
+typedef struct {
+  usbep_t ep;
+  uint8_t size;
+  uint8_t head;         /* free running, masked on access */
+  uint8_t tail;         /* slot being transmitted while in_flight */
+  bool in_flight;
+  thread_reference_t waiting;   /* thread sleeping on a full ring */
+  uint8_t *buffer;
+} report_ring_t;
+
+#define REPORT_RING(name, epnum, report_size) \
+  static uint8_t name##_buffer[USB_REPORT_QUEUE_SIZE * (report_size)] __attribute__((aligned(4))); \
+  static report_ring_t name = { \
+    .ep = epnum, \
+    .size = report_size, \
+    .buffer = name##_buffer \
+  }
+
+REPORT_RING(kbd_ring, KBD_ENDPOINT, KBD_EPSIZE);
+#ifdef NKRO_ENABLE
+REPORT_RING(nkro_ring, NKRO_ENDPOINT, sizeof(report_keyboard_t));
+#endif /* NKRO_ENABLE */
+#ifdef MOUSE_ENABLE
+REPORT_RING(mouse_ring, MOUSE_ENDPOINT, sizeof(report_mouse_t));
+#endif /* MOUSE_ENABLE */
+#ifdef EXTRAKEY_ENABLE
+REPORT_RING(extra_ring, EXTRA_ENDPOINT, sizeof(report_extra_t));
+#endif /* EXTRAKEY_ENABLE */
+
+static inline uint8_t *report_ring_slot(report_ring_t *ring, uint8_t index) {
+  return &ring->buffer[(index & (USB_REPORT_QUEUE_SIZE - 1)) * ring->size];
+}
+
+/* Start transmitting the oldest queued report if the endpoint is idle
+ * Called from a locked state */
+static void report_ring_kickI(USBDriver *usbp, report_ring_t *ring) {
+  if(ring->in_flight || ring->head == ring->tail)
+    return;
+  if(usbGetDriverStateI(usbp) != USB_ACTIVE || usbGetTransmitStatusI(usbp, ring->ep))
+    return;
+  ring->in_flight = true;
+  usbStartTransmitI(usbp, ring->ep, report_ring_slot(ring, ring->tail), ring->size);
+}
+
+static inline bool report_ring_is_full(report_ring_t *ring) {
+  return (uint8_t)(ring->head - ring->tail) == USB_REPORT_QUEUE_SIZE;
+}
+
+/* Nothing is waiting besides the report being transmitted
+ * Called from a locked state */
+static inline bool report_ring_is_idleI(report_ring_t *ring) {
+  return (uint8_t)(ring->head - ring->tail) <= (ring->in_flight ? 1 : 0);
+}
+
+/* Queue a report
+ * Only a single event sending more reports than the ring holds finds it
+ * full. The caller then sleeps until the IN callback frees a slot, so the
+ * report is never dropped; a host that goes away ends the wait.
+ * Called from a locked thread state, not from ISR */
+static void report_ring_pushS(USBDriver *usbp, report_ring_t *ring, const void *report) {
+  while(report_ring_is_full(ring)) {
+    if(usbGetDriverStateI(usbp) != USB_ACTIVE)
+      return;
+    /* the timeout only re-checks the driver state */
+    osalThreadSuspendTimeoutS(&ring->waiting, MS2ST(10));
+  }
+  memcpy(report_ring_slot(ring, ring->head), report, ring->size);
+  ring->head++;
+  report_ring_kickI(usbp, ring);
+}
+
+/* A transfer on the ring's endpoint completed; chain the next one
+ * Called from ISR */
+static void report_ring_in_cb(USBDriver *usbp, report_ring_t *ring) {
+  osalSysLockFromISR();
+  if(ring->in_flight) {
+    ring->in_flight = false;
+    ring->tail++;
+    osalThreadResumeI(&ring->waiting, MSG_OK);
+  }
+  report_ring_kickI(usbp, ring);
+  osalSysUnlockFromISR();
+}
+
+static void report_ring_clearI(report_ring_t *ring) {
+  ring->tail = ring->head;
+  ring->in_flight = false;
+  osalThreadResumeI(&ring->waiting, MSG_RESET);
+}
+
+/* The host stopped polling and a transfer in flight was aborted, it is
+ * sent again from the start of the ring once the bus is back */
+static void report_ring_abortI(report_ring_t *ring) {
+  ring->in_flight = false;
+  osalThreadResumeI(&ring->waiting, MSG_RESET);
+}
+
+/* Drop everything queued (on reset and (re)configuration)
+ * Called from a locked state */
+static void report_rings_resetI(void) {
+  report_ring_clearI(&kbd_ring);
+#ifdef NKRO_ENABLE
+  report_ring_clearI(&nkro_ring);
+#endif /* NKRO_ENABLE */
+#ifdef MOUSE_ENABLE
+  report_ring_clearI(&mouse_ring);
+#endif /* MOUSE_ENABLE */
+#ifdef EXTRAKEY_ENABLE
+  report_ring_clearI(&extra_ring);
+#endif /* EXTRAKEY_ENABLE */
+}
+
+/* Called from a locked state */
+static void report_rings_abortI(void) {
+  report_ring_abortI(&kbd_ring);
+#ifdef NKRO_ENABLE
+  report_ring_abortI(&nkro_ring);
+#endif /* NKRO_ENABLE */
+#ifdef MOUSE_ENABLE
+  report_ring_abortI(&mouse_ring);
+#endif /* MOUSE_ENABLE */
+#ifdef EXTRAKEY_ENABLE
+  report_ring_abortI(&extra_ring);
+#endif /* EXTRAKEY_ENABLE */
+}
+
+/* Restart the transfers after a wakeup
+ * Called from a locked state */
+static void report_rings_kickI(USBDriver *usbp) {
+  report_ring_kickI(usbp, &kbd_ring);
+#ifdef NKRO_ENABLE
+  report_ring_kickI(usbp, &nkro_ring);
+#endif /* NKRO_ENABLE */
+#ifdef MOUSE_ENABLE
+  report_ring_kickI(usbp, &mouse_ring);
+#endif /* MOUSE_ENABLE */
+#ifdef EXTRAKEY_ENABLE
+  report_ring_kickI(usbp, &extra_ring);
+#endif /* EXTRAKEY_ENABLE */
+}
+
 /* ---------------------------------------------------------
  *                  USB driver functions
  * ---------------------------------------------------------
@@ -780,6 +948,10 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
   switch(event) {
   case USB_EVENT_RESET:
     //TODO: from ISR! print("[R]");
+    /* The endpoints are gone, and so is any transfer in flight */
+    osalSysLockFromISR();
+    report_rings_resetI();
+    osalSysUnlockFromISR();
     return;
 
   case USB_EVENT_ADDRESS:
@@ -787,6 +959,8 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
 
   case USB_EVENT_CONFIGURED:
     osalSysLockFromISR();
+    /* Anything queued for the previous configuration is stale */
+    report_rings_resetI();
     /* Enable the endpoints specified into the configuration. */
     usbInitEndpointI(usbp, KBD_ENDPOINT, &kbd_ep_config);
 #ifdef MOUSE_ENABLE
@@ -807,6 +981,10 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
 
   case USB_EVENT_SUSPEND:
     //TODO: from ISR! print("[S]");
+    /* A transfer in flight never completes, send it again after wakeup */
+    osalSysLockFromISR();
+    report_rings_abortI();
+    osalSysUnlockFromISR();
 #ifdef SLEEP_LED_ENABLE
     sleep_led_enable();
 #endif /* SLEEP_LED_ENABLE */
@@ -814,6 +992,10 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
 
   case USB_EVENT_WAKEUP:
     //TODO: from ISR! print("[W]");
+    osalSysLockFromISR();
+    report_rings_abortI();
+    report_rings_kickI(usbp);
+    osalSysUnlockFromISR();
     suspend_wakeup_init();
 #ifdef SLEEP_LED_ENABLE
     sleep_led_disable();
@@ -1065,27 +1247,64 @@ void send_remote_wakeup(USBDriver *usbp) {
 
 /* keyboard IN callback hander (a kbd report has made it IN) */
 void kbd_in_cb(USBDriver *usbp, usbep_t ep) {
-  /* STUB */
-  (void)usbp;
   (void)ep;
+  report_ring_in_cb(usbp, &kbd_ring);
 }
 
 #ifdef NKRO_ENABLE
 /* nkro IN callback hander (a nkro report has made it IN) */
 void nkro_in_cb(USBDriver *usbp, usbep_t ep) {
-  /* STUB */
-  (void)usbp;
   (void)ep;
+  report_ring_in_cb(usbp, &nkro_ring);
 }
 #endif /* NKRO_ENABLE */
 
+#ifdef USB_SOF_SYNC
+static volatile uint8_t sof_count = 0;
+static uint8_t sof_seen = 0;
+static uint16_t sof_overruns = 0;
+static thread_reference_t sof_waiting_thread = NULL;
+#endif /* USB_SOF_SYNC */
+
 /* start-of-frame handler
  * TODO: i guess it would be better to re-implement using timers,
  *  so that this is not going to have to be checked every 1ms */
 void kbd_sof_cb(USBDriver *usbp) {
   (void)usbp;
+#ifdef USB_SOF_SYNC
+  osalSysLockFromISR();
+  sof_count++;
+  osalThreadResumeI(&sof_waiting_thread, MSG_OK);
+  osalSysUnlockFromISR();
+#endif /* USB_SOF_SYNC */
 }
 
+#ifdef USB_SOF_SYNC
+/* Sleep until the next Start-of-Frame so the following scan and report
+ * land at a fixed point in the frame. A scan that spanned more than one
+ * frame is counted as an overrun.
+ * not callable from ISR or locked state */
+void usb_sof_sync_wait(void) {
+  osalSysLock();
+  if(usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+    osalSysUnlock();
+    return;
+  }
+  if((uint8_t)(sof_count - sof_seen) > 1 && sof_overruns < UINT16_MAX)
+    sof_overruns++;
+  if(sof_count == sof_seen) {
+    /* time out in case the host stops sending SOFs */
+    osalThreadSuspendTimeoutS(&sof_waiting_thread, MS2ST(2));
+  }
+  sof_seen = sof_count;
+  osalSysUnlock();
+}
+
+uint16_t usb_sof_sync_overruns(void) {
+  return sof_overruns;
+}
+#endif /* USB_SOF_SYNC */
+
 /* Idle requests timer code
  * callback (called from ISR, unlocked state) */
 static void keyboard_idle_timer_cb(void *arg) {
@@ -1123,7 +1342,7 @@ uint8_t keyboard_leds(void) {
   return (uint8_t)(keyboard_led_stats & 0xFF);
 }
 
-/* prepare and start sending a report IN
+/* queue a report IN; only waits for the host when the ring is full
  * not callable from ISR or locked state */
 void send_keyboard(report_keyboard_t *report) {
   osalSysLock();
@@ -1131,42 +1350,33 @@ void send_keyboard(report_keyboard_t *report) {
     osalSysUnlock();
     return;
   }
-  osalSysUnlock();
 
 #ifdef NKRO_ENABLE
   if(keymap_config.nkro) {  /* NKRO protocol */
-    /* need to wait until the previous packet has made it through */
-    /* can rewrite this using the synchronous API, then would wait
-     * until *after* the packet has been transmitted. I think
-     * this is more efficient */
-    /* busy wait, should be short and not very common */
-    osalSysLock();
-    if(usbGetTransmitStatusI(&USB_DRIVER, NKRO_ENDPOINT)) {
-      /* Need to either suspend, or loop and call unlock/lock during
-       * every iteration - otherwise the system will remain locked,
-       * no interrupts served, so USB not going through as well.
-       * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-      osalThreadSuspendS(&(&USB_DRIVER)->epc[NKRO_ENDPOINT]->in_state->thread);
-    }
-    usbStartTransmitI(&USB_DRIVER, NKRO_ENDPOINT, (uint8_t *)report, sizeof(report_keyboard_t));
-    osalSysUnlock();
+    report_ring_pushS(&USB_DRIVER, &nkro_ring, report);
   } else
 #endif /* NKRO_ENABLE */
   { /* boot protocol */
-    /* need to wait until the previous packet has made it through */
-    /* busy wait, should be short and not very common */
-    osalSysLock();
-    if(usbGetTransmitStatusI(&USB_DRIVER, KBD_ENDPOINT)) {
-      /* Need to either suspend, or loop and call unlock/lock during
-       * every iteration - otherwise the system will remain locked,
-       * no interrupts served, so USB not going through as well.
-       * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-      osalThreadSuspendS(&(&USB_DRIVER)->epc[KBD_ENDPOINT]->in_state->thread);
-    }
-    usbStartTransmitI(&USB_DRIVER, KBD_ENDPOINT, (uint8_t *)report, KBD_EPSIZE);
-    osalSysUnlock();
+    report_ring_pushS(&USB_DRIVER, &kbd_ring, report);
   }
   keyboard_report_sent = *report;
+  osalSysUnlock();
+}
+
+/* The keyboard code holds back its next event while reports are waiting,
+ * see host_keyboard_ready()
+ * not callable from ISR or locked state */
+bool host_keyboard_ready(void) {
+  bool ready = true;
+  osalSysLock();
+  if(usbGetDriverStateI(&USB_DRIVER) == USB_ACTIVE) {
+    ready = report_ring_is_idleI(&kbd_ring);
+#ifdef NKRO_ENABLE
+    ready = ready && report_ring_is_idleI(&nkro_ring);
+#endif /* NKRO_ENABLE */
+  }
+  osalSysUnlock();
+  return ready;
 }
 
 /* ---------------------------------------------------------
@@ -1178,8 +1388,8 @@ void send_keyboard(report_keyboard_t *report) {
 
 /* mouse IN callback hander (a mouse report has made it IN) */
 void mouse_in_cb(USBDriver *usbp, usbep_t ep) {
-  (void)usbp;
   (void)ep;
+  report_ring_in_cb(usbp, &mouse_ring);
 }
 
 void send_mouse(report_mouse_t *report) {
@@ -1188,15 +1398,26 @@ void send_mouse(report_mouse_t *report) {
     osalSysUnlock();
     return;
   }
-  osalSysUnlock();
 
-  /* TODO: LUFA manually waits for the endpoint to become ready
-   * for about 10ms for mouse, kbd, system; 1ms for nkro
-   * is this really needed?
-   */
+  /* Fold motion into the newest waiting report rather than wait for a
+   * slot; with a full ring that is never the report in flight */
+  if(report_ring_is_full(&mouse_ring)) {
+    report_mouse_t *last = (report_mouse_t *)report_ring_slot(&mouse_ring, mouse_ring.head - 1);
+    if(last->buttons == report->buttons &&
+       last->x + report->x == (int8_t)(last->x + report->x) &&
+       last->y + report->y == (int8_t)(last->y + report->y) &&
+       last->v + report->v == (int8_t)(last->v + report->v) &&
+       last->h + report->h == (int8_t)(last->h + report->h)) {
+      last->x += report->x;
+      last->y += report->y;
+      last->v += report->v;
+      last->h += report->h;
+      osalSysUnlock();
+      return;
+    }
+  }
 
-  osalSysLock();
-  usbStartTransmitI(&USB_DRIVER, MOUSE_ENDPOINT, (uint8_t *)report, sizeof(report_mouse_t));
+  report_ring_pushS(&USB_DRIVER, &mouse_ring, report);
   osalSysUnlock();
 }
 
@@ -1215,9 +1436,8 @@ void send_mouse(report_mouse_t *report) {
 
 /* extrakey IN callback hander */
 void extra_in_cb(USBDriver *usbp, usbep_t ep) {
-  /* STUB */
-  (void)usbp;
   (void)ep;
+  report_ring_in_cb(usbp, &extra_ring);
 }
 
 static void send_extra_report(uint8_t report_id, uint16_t data) {
@@ -1232,7 +1452,7 @@ static void send_extra_report(uint8_t report_id, uint16_t data) {
     .usage = data
   };
 
-  usbStartTransmitI(&USB_DRIVER, EXTRA_ENDPOINT, (uint8_t *)&report, sizeof(report_extra_t));
+  report_ring_pushS(&USB_DRIVER, &extra_ring, &report);
   osalSysUnlock();
 }
 
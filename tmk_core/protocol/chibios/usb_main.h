@@ -66,6 +66,14 @@ void kbd_in_cb(USBDriver *usbp, usbep_t ep);
 /* start-of-frame handler */
 void kbd_sof_cb(USBDriver *usbp);
 
+#ifdef USB_SOF_SYNC
+/* Wait for the next start-of-frame before scanning */
+void usb_sof_sync_wait(void);
+
+/* Number of scans that did not finish within one USB frame */
+uint16_t usb_sof_sync_overruns(void);
+#endif /* USB_SOF_SYNC */
+
 #ifdef NKRO_ENABLE
 /* nkro IN callback hander */
 void nkro_in_cb(USBDriver *usbp, usbep_t ep);
@@ -18,6 +18,8 @@ Copyright 2010,2011,2012,2013 Jun WAKO <wakojun@gmail.com>
 
 uint8_t ibm4704_error = 0;
 
+RING_BUFFER(rbuf, uint8_t, 32)
+
 
 void ibm4704_init(void)
 {
@@ -99,16 +101,18 @@ ERROR:
 /* wait forever to receive data */
 uint8_t ibm4704_recv_response(void)
 {
-    while (!rbuf_has_data()) {
+    uint8_t data;
+    while (!rbuf_get(&data)) {
         _delay_ms(1);
     }
-    return rbuf_dequeue();
+    return data;
 }
 
 uint8_t ibm4704_recv(void)
 {
-    if (rbuf_has_data()) {
-        return rbuf_dequeue();
+    uint8_t data;
+    if (rbuf_get(&data)) {
+        return data;
     } else {
         return -1;
     }
@@ -167,7 +171,9 @@ ISR(IBM4704_INT_VECT)
         case STOP:
             // Data:Low
             WAIT(data_lo, 100, state);
-            rbuf_enqueue(data);
+            if (!rbuf_put(data)) {
+                print("rbuf: full\n");
+            }
             ibm4704_error = IBM4704_ERR_NONE;
             goto DONE;
             break;
@@ -318,6 +318,149 @@ static void Console_Task(void)
 #endif
 
 
+/*******************************************************************************
+ * Report queue
+ *
+ * Reports are queued per endpoint from the main loop and written out once the
+ * endpoint bank is free, so the host driver never spins waiting for the host
+ * to poll. The queues are only touched from the main loop.
+ *
+ * The keyboard code checks host_keyboard_ready() and leaves its next event
+ * for a later loop while reports are waiting, so a queue only fills up when
+ * one event sends a lot of reports at once. The caller of such a report is
+ * held back until the host takes one, see report_queue_push(); reports are
+ * never dropped or replaced.
+ ******************************************************************************/
+#ifndef USB_REPORT_QUEUE_SIZE
+#define USB_REPORT_QUEUE_SIZE 4
+#endif
+
+#if (USB_REPORT_QUEUE_SIZE & (USB_REPORT_QUEUE_SIZE - 1)) != 0 || USB_REPORT_QUEUE_SIZE > 128
+#error "USB_REPORT_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+typedef struct {
+    uint8_t  ep;
+    uint8_t  size;
+    uint8_t  head;  /* free running, masked on access */
+    uint8_t  tail;
+    uint8_t *buffer;
+} report_queue_t;
+
+#define REPORT_QUEUE(name, epnum, report_size) \
+    static uint8_t name##_buffer[USB_REPORT_QUEUE_SIZE * (report_size)]; \
+    static report_queue_t name = { \
+        .ep = epnum, \
+        .size = report_size, \
+        .buffer = name##_buffer \
+    }
+
+REPORT_QUEUE(keyboard_queue, KEYBOARD_IN_EPNUM, KEYBOARD_EPSIZE);
+#ifdef NKRO_ENABLE
+REPORT_QUEUE(nkro_queue, NKRO_IN_EPNUM, NKRO_EPSIZE);
+#endif
+#ifdef MOUSE_ENABLE
+REPORT_QUEUE(mouse_queue, MOUSE_IN_EPNUM, sizeof(report_mouse_t));
+#endif
+#ifdef EXTRAKEY_ENABLE
+REPORT_QUEUE(extrakey_queue, EXTRAKEY_IN_EPNUM, sizeof(report_extra_t));
+#endif
+
+static inline bool report_queue_is_full(report_queue_t *q)
+{
+    return (uint8_t)(q->head - q->tail) == USB_REPORT_QUEUE_SIZE;
+}
+
+static inline uint8_t *report_queue_slot(report_queue_t *q, uint8_t index)
+{
+    return &q->buffer[(index & (USB_REPORT_QUEUE_SIZE - 1)) * q->size];
+}
+
+/* Write out as many queued reports as the endpoint will take right now */
+static void report_queue_flush(report_queue_t *q)
+{
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return;
+
+    while (q->head != q->tail) {
+        Endpoint_SelectEndpoint(q->ep);
+        if (!Endpoint_IsReadWriteAllowed())
+            return;
+
+        Endpoint_Write_Stream_LE(report_queue_slot(q, q->tail), q->size, NULL);
+        Endpoint_ClearIN();
+        q->tail++;
+    }
+}
+
+/* Queue a report and send it straight away if the endpoint is free.
+ *
+ * The scan loop, macros, Unicode and send_string() all wait for
+ * host_keyboard_ready() between their steps, so a full queue here means a
+ * single event sent more than USB_REPORT_QUEUE_SIZE reports. The report is
+ * not dropped: the caller is held back, with the USB stack serviced, until
+ * the host takes the oldest one. Only a host that goes away ends the wait,
+ * the queues are cleared when it configures the device again.
+ */
+static void report_queue_push(report_queue_t *q, const void *report)
+{
+    report_queue_flush(q);
+
+    while (report_queue_is_full(q)) {
+        if (USB_DeviceState != DEVICE_STATE_Configured)
+            return;
+#if !defined(INTERRUPT_CONTROL_ENDPOINT)
+        USB_USBTask();
+#endif
+        report_queue_flush(q);
+    }
+
+    memcpy(report_queue_slot(q, q->head), report, q->size);
+    q->head++;
+
+    report_queue_flush(q);
+}
+
+/* Nothing is waiting for the endpoint besides what is already in the bank */
+static inline bool report_queue_is_empty(report_queue_t *q)
+{
+    return q->head == q->tail;
+}
+
+static void report_queue_clear(report_queue_t *q)
+{
+    q->tail = q->head;
+}
+
+static void report_queue_task(void)
+{
+    report_queue_flush(&keyboard_queue);
+#ifdef NKRO_ENABLE
+    report_queue_flush(&nkro_queue);
+#endif
+#ifdef MOUSE_ENABLE
+    report_queue_flush(&mouse_queue);
+#endif
+#ifdef EXTRAKEY_ENABLE
+    report_queue_flush(&extrakey_queue);
+#endif
+}
+
+static void report_queue_reset(void)
+{
+    report_queue_clear(&keyboard_queue);
+#ifdef NKRO_ENABLE
+    report_queue_clear(&nkro_queue);
+#endif
+#ifdef MOUSE_ENABLE
+    report_queue_clear(&mouse_queue);
+#endif
+#ifdef EXTRAKEY_ENABLE
+    report_queue_clear(&extrakey_queue);
+#endif
+}
+
+
 /*******************************************************************************
  * USB Events
  ******************************************************************************/
@@ -388,8 +531,7 @@ static bool console_flush = false;
   } \
 } while (0)
 
-// called every 1ms
-void EVENT_USB_Device_StartOfFrame(void)
+static void console_sof(void)
 {
     static uint8_t count;
     if (++count % 50) return;
@@ -399,7 +541,56 @@ void EVENT_USB_Device_StartOfFrame(void)
     Console_Task();
     console_flush = false;
 }
+#endif
+
+#ifdef USB_SOF_SYNC
+static volatile uint8_t sof_count = 0;
+static uint8_t sof_seen = 0;
+static uint16_t sof_overruns = 0;
+
+/* Idle until the next Start-of-Frame so the following scan and report
+ * land at a fixed point in the frame. A scan that spanned more than one
+ * frame is counted as an overrun.
+ */
+static void sof_sync_wait(void)
+{
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return;
 
+    if ((uint8_t)(sof_count - sof_seen) > 1 && sof_overruns < UINT16_MAX)
+        sof_overruns++;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (sof_count == sof_seen && USB_DeviceState == DEVICE_STATE_Configured) {
+        cli();
+        if (sof_count == sof_seen) {
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+    sof_seen = sof_count;
+}
+
+uint16_t usb_sof_sync_overruns(void)
+{
+    return sof_overruns;
+}
+#endif
+
+#if defined(CONSOLE_ENABLE) || defined(USB_SOF_SYNC)
+// called every 1ms
+void EVENT_USB_Device_StartOfFrame(void)
+{
+#ifdef USB_SOF_SYNC
+    sof_count++;
+#endif
+#ifdef CONSOLE_ENABLE
+    console_sof();
+#endif
+}
 #endif
 
 /** Event handler for the USB_ConfigurationChanged event.
@@ -412,6 +603,9 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 {
     bool ConfigSuccess = true;
 
+    /* Reports queued for a previous configuration are stale */
+    report_queue_reset();
+
     /* Setup Keyboard HID Report Endpoints */
     ConfigSuccess &= ENDPOINT_CONFIG(KEYBOARD_IN_EPNUM, EP_TYPE_INTERRUPT, ENDPOINT_DIR_IN,
                                      KEYBOARD_EPSIZE, ENDPOINT_BANK_SINGLE);
@@ -599,7 +793,6 @@ static uint8_t keyboard_leds(void)
 
 static void send_keyboard(report_keyboard_t *report)
 {
-    uint8_t timeout = 255;
     uint8_t where = where_to_send();
 
 #ifdef BLUETOOTH_ENABLE
@@ -626,43 +819,41 @@ static void send_keyboard(report_keyboard_t *report)
       return;
     }
 
-    /* Select the Keyboard Report Endpoint */
+    /* Queue on the Keyboard Report Endpoint */
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keymap_config.nkro) {
         /* Report protocol - NKRO */
-        Endpoint_SelectEndpoint(NKRO_IN_EPNUM);
-
-        /* Check if write ready for a polling interval around 1ms */
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(4);
-        if (!Endpoint_IsReadWriteAllowed()) return;
-
-        /* Write Keyboard Report Data */
-        Endpoint_Write_Stream_LE(report, NKRO_EPSIZE, NULL);
+        report_queue_push(&nkro_queue, report);
     }
     else
 #endif
     {
         /* Boot protocol */
-        Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
-
-        /* Check if write ready for a polling interval around 10ms */
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-        if (!Endpoint_IsReadWriteAllowed()) return;
-
-        /* Write Keyboard Report Data */
-        Endpoint_Write_Stream_LE(report, KEYBOARD_EPSIZE, NULL);
+        report_queue_push(&keyboard_queue, report);
     }
 
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
-
     keyboard_report_sent = *report;
 }
 
+/* The keyboard code holds back its next event while reports are waiting,
+ * see host_keyboard_ready() */
+bool host_keyboard_ready(void)
+{
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return true;
+
+#ifdef NKRO_ENABLE
+    report_queue_flush(&nkro_queue);
+    if (!report_queue_is_empty(&nkro_queue))
+        return false;
+#endif
+    report_queue_flush(&keyboard_queue);
+    return report_queue_is_empty(&keyboard_queue);
+}
+
 static void send_mouse(report_mouse_t *report)
 {
 #ifdef MOUSE_ENABLE
-    uint8_t timeout = 255;
     uint8_t where = where_to_send();
 
 #ifdef BLUETOOTH_ENABLE
@@ -688,25 +879,31 @@ static void send_mouse(report_mouse_t *report)
       return;
     }
 
-    /* Select the Mouse Report Endpoint */
-    Endpoint_SelectEndpoint(MOUSE_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    /* Write Mouse Report Data */
-    Endpoint_Write_Stream_LE(report, sizeof(report_mouse_t), NULL);
+    /* Fold motion into the newest waiting report rather than wait for a slot */
+    report_queue_flush(&mouse_queue);
+    if (report_queue_is_full(&mouse_queue)) {
+        report_mouse_t *last = (report_mouse_t *)report_queue_slot(&mouse_queue, mouse_queue.head - 1);
+        if (last->buttons == report->buttons &&
+            last->x + report->x == (int8_t)(last->x + report->x) &&
+            last->y + report->y == (int8_t)(last->y + report->y) &&
+            last->v + report->v == (int8_t)(last->v + report->v) &&
+            last->h + report->h == (int8_t)(last->h + report->h)) {
+            last->x += report->x;
+            last->y += report->y;
+            last->v += report->v;
+            last->h += report->h;
+            report_queue_flush(&mouse_queue);
+            return;
+        }
+    }
 
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
+    report_queue_push(&mouse_queue, report);
 #endif
 }
 
 static void send_system(uint16_t data)
 {
-    uint8_t timeout = 255;
-
+#ifdef EXTRAKEY_ENABLE
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
@@ -714,19 +911,12 @@ static void send_system(uint16_t data)
         .report_id = REPORT_ID_SYSTEM,
         .usage = data - SYSTEM_POWER_DOWN + 1
     };
-    Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    report_queue_push(&extrakey_queue, &r);
+#endif
 }
 
 static void send_consumer(uint16_t data)
 {
-    uint8_t timeout = 255;
     uint8_t where = where_to_send();
 
 #ifdef BLUETOOTH_ENABLE
@@ -765,18 +955,13 @@ static void send_consumer(uint16_t data)
       return;
     }
 
+#ifdef EXTRAKEY_ENABLE
     report_extra_t r = {
         .report_id = REPORT_ID_CONSUMER,
         .usage = data
     };
-    Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    report_queue_push(&extrakey_queue, &r);
+#endif
 }
 
 
@@ -1190,7 +1375,11 @@ int main(void)
         }
         #endif
 
+#ifdef USB_SOF_SYNC
+        sof_sync_wait();
+#endif
         keyboard_task();
+        report_queue_task();
 
 #ifdef MIDI_ENABLE
         midi_device_process(&midi_device);
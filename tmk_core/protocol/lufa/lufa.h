@@ -43,6 +43,7 @@
 #include <avr/wdt.h>
 #include <avr/power.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <stdbool.h>
 #include <string.h>
 #include <LUFA/Version.h>
@@ -57,6 +58,11 @@ extern "C" {
 
 extern host_driver_t lufa_driver;
 
+#ifdef USB_SOF_SYNC
+/* Number of scans that did not finish within one USB frame */
+uint16_t usb_sof_sync_overruns(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
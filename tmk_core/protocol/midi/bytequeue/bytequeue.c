@@ -18,7 +18,9 @@
 //along with avr-bytequeue.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "bytequeue.h"
-#include "interrupt_setting.h"
+
+//the queue is single producer, single consumer: only enqueue writes end and
+//only remove writes start, so neither side has to disable interrupts
 
 void bytequeue_init(byteQueue_t * queue, uint8_t * dataArray, byteQueueIndex_t arrayLen){
    queue->length = arrayLen;
@@ -27,39 +29,33 @@ void bytequeue_init(byteQueue_t * queue, uint8_t * dataArray, byteQueueIndex_t a
 }
 
 bool bytequeue_enqueue(byteQueue_t * queue, uint8_t item){
-   interrupt_setting_t setting = store_and_clear_interrupt();
+   byteQueueIndex_t end = queue->end;
+   byteQueueIndex_t next = (end + 1) % queue->length;
    //full
-   if(((queue->end + 1) % queue->length) == queue->start){
-      restore_interrupt_setting(setting);
+   if(next == queue->start)
       return false;
-   } else {
-      queue->data[queue->end] = item;
-      queue->end = (queue->end + 1) % queue->length;
-      restore_interrupt_setting(setting);
-      return true;
-   }
+   queue->data[end] = item;
+   //publish the item before the new end
+   __asm__ __volatile__ ("" ::: "memory");
+   queue->end = next;
+   return true;
 }
 
 byteQueueIndex_t bytequeue_length(byteQueue_t * queue){
-   byteQueueIndex_t len;
-   interrupt_setting_t setting = store_and_clear_interrupt();
-   if(queue->end >= queue->start)
-      len = queue->end - queue->start;
+   byteQueueIndex_t start = queue->start;
+   byteQueueIndex_t end = queue->end;
+   if(end >= start)
+      return end - start;
    else
-      len = (queue->length - queue->start) + queue->end;
-   restore_interrupt_setting(setting);
-   return len;
+      return (queue->length - start) + end;
 }
 
-//we don't need to avoid interrupts if there is only one reader
 uint8_t bytequeue_get(byteQueue_t * queue, byteQueueIndex_t index){
    return queue->data[(queue->start + index) % queue->length];
 }
 
-//we just update the start index to remove elements
 void bytequeue_remove(byteQueue_t * queue, byteQueueIndex_t numToRemove){
-   interrupt_setting_t setting = store_and_clear_interrupt();
+   //finish reading the items before handing their slots back
+   __asm__ __volatile__ ("" ::: "memory");
    queue->start = (queue->start + numToRemove) % queue->length;
-   restore_interrupt_setting(setting);
 }
-
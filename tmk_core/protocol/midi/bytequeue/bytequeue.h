@@ -30,8 +30,8 @@ extern "C" {
 typedef uint8_t byteQueueIndex_t;
 
 typedef struct {
-	byteQueueIndex_t start;
-	byteQueueIndex_t end;
+	volatile byteQueueIndex_t start;
+	volatile byteQueueIndex_t end;
 	byteQueueIndex_t length;
 	uint8_t * data;
 } byteQueue_t;
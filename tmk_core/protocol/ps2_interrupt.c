@@ -45,6 +45,10 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "ps2.h"
 #include "ps2_io.h"
 #include "print.h"
+#include "ring_buffer.h"
+#ifdef PS2_MOUSE_ENABLE
+#include "ps2_mouse.h"
+#endif
 
 
 #define WAIT(stat, us, err) do { \
@@ -58,10 +62,10 @@ POSSIBILITY OF SUCH DAMAGE.
 uint8_t ps2_error = PS2_ERR_NONE;
 
 
-static inline uint8_t pbuf_dequeue(void);
-static inline void pbuf_enqueue(uint8_t data);
-static inline bool pbuf_has_data(void);
-static inline void pbuf_clear(void);
+/*--------------------------------------------------------------------
+ * Ring buffer to store scan codes from keyboard
+ *------------------------------------------------------------------*/
+RING_BUFFER(pbuf, uint8_t, 32)
 
 
 void ps2_host_init(void)
@@ -133,18 +137,20 @@ uint8_t ps2_host_recv_response(void)
 {
     // Command may take 25ms/20ms at most([5]p.46, [3]p.21)
     uint8_t retry = 25;
-    while (retry-- && !pbuf_has_data()) {
+    uint8_t data = 0;
+    while (retry-- && !pbuf_get(&data)) {
         _delay_ms(1);
     }
-    return pbuf_dequeue();
+    return data;
 }
 
 /* get data received by interrupt */
 uint8_t ps2_host_recv(void)
 {
-    if (pbuf_has_data()) {
+    uint8_t data;
+    if (pbuf_get(&data)) {
         ps2_error = PS2_ERR_NONE;
-        return pbuf_dequeue();
+        return data;
     } else {
         ps2_error = PS2_ERR_NODATA;
         return 0;
@@ -202,7 +208,12 @@ ISR(PS2_INT_VECT)
         case STOP:
             if (!data_in())
                 goto ERROR;
-            pbuf_enqueue(data);
+#ifdef PS2_MOUSE_USE_STREAM_INT
+            if (!ps2_mouse_stream_byte(data))
+#endif
+            if (!pbuf_put(data)) {
+                print("pbuf: full\n");
+            }
             goto DONE;
             break;
         default:
@@ -226,54 +237,3 @@ void ps2_host_set_led(uint8_t led)
     ps2_host_send(led);
 }
 
-
-/*--------------------------------------------------------------------
- * Ring buffer to store scan codes from keyboard
- *------------------------------------------------------------------*/
-#define PBUF_SIZE 32
-static uint8_t pbuf[PBUF_SIZE];
-static uint8_t pbuf_head = 0;
-static uint8_t pbuf_tail = 0;
-static inline void pbuf_enqueue(uint8_t data)
-{
-    uint8_t sreg = SREG;
-    cli();
-    uint8_t next = (pbuf_head + 1) % PBUF_SIZE;
-    if (next != pbuf_tail) {
-        pbuf[pbuf_head] = data;
-        pbuf_head = next;
-    } else {
-        print("pbuf: full\n");
-    }
-    SREG = sreg;
-}
-static inline uint8_t pbuf_dequeue(void)
-{
-    uint8_t val = 0;
-
-    uint8_t sreg = SREG;
-    cli();
-    if (pbuf_head != pbuf_tail) {
-        val = pbuf[pbuf_tail];
-        pbuf_tail = (pbuf_tail + 1) % PBUF_SIZE;
-    }
-    SREG = sreg;
-
-    return val;
-}
-static inline bool pbuf_has_data(void)
-{
-    uint8_t sreg = SREG;
-    cli();
-    bool has_data = (pbuf_head != pbuf_tail);
-    SREG = sreg;
-    return has_data;
-}
-static inline void pbuf_clear(void)
-{
-    uint8_t sreg = SREG;
-    cli();
-    pbuf_head = pbuf_tail = 0;
-    SREG = sreg;
-}
-
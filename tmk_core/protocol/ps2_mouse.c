@@ -16,7 +16,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include<avr/io.h>
+#include<avr/interrupt.h>
 #include<util/delay.h>
 #include "ps2_mouse.h"
 #include "host.h"
@@ -25,6 +27,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "report.h"
 #include "debug.h"
 #include "ps2.h"
+#include "ps2_mouse_packet.h"
+#ifdef POINTING_DEVICE_ENABLE
+#include "pointing_device.h"
+#endif
 
 /* ============================= MACROS ============================ */
 
@@ -32,10 +38,17 @@ static report_mouse_t mouse_report = {};
 
 static inline void ps2_mouse_print_report(report_mouse_t *mouse_report);
 static inline void ps2_mouse_convert_report_to_hid(report_mouse_t *mouse_report);
+static inline void ps2_mouse_orient_report(report_mouse_t *mouse_report);
+static inline void ps2_mouse_send_report(report_mouse_t *mouse_report);
 static inline void ps2_mouse_clear_report(report_mouse_t *mouse_report);
 static inline void ps2_mouse_enable_scrolling(void);
 static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report);
 
+#ifdef PS2_MOUSE_USE_STREAM_INT
+static volatile bool stream_enabled = false;
+static volatile uint8_t stream_paused = 0;
+#endif
+
 /* ============================= IMPLEMENTATION ============================ */
 
 /* supports only 3 button mouse at this time */
@@ -64,12 +77,118 @@ void ps2_mouse_init(void) {
 #endif
 
     ps2_mouse_init_user();
+
+#ifdef PS2_MOUSE_USE_STREAM_INT
+    // not before, ps2_mouse_init_user() may talk to the mouse directly
+    stream_enabled = true;
+#endif
 }
 
 __attribute__((weak))
 void ps2_mouse_init_user(void) {
 }
 
+#ifdef PS2_MOUSE_USE_STREAM_INT
+#ifdef PS2_MOUSE_ENABLE_SCROLLING
+#define PS2_MOUSE_PACKET_SIZE 4
+#else
+#define PS2_MOUSE_PACKET_SIZE 3
+#endif
+
+static int16_t saturate(int32_t value, int16_t limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+bool ps2_mouse_stream_byte(uint8_t data) {
+    static uint8_t packet[PS2_MOUSE_PACKET_SIZE];
+    static uint8_t packet_pos = 0;
+    static uint16_t last_byte = 0;
+
+    if (!stream_enabled || stream_paused) {
+        packet_pos = 0;
+        return false;
+    }
+
+    // start over after a partial packet
+    if (packet_pos && timer_elapsed(last_byte) > 10) {
+        packet_pos = 0;
+    }
+    last_byte = timer_read();
+
+    // bit 3 of the first byte is always set, skip bytes until in sync
+    if (packet_pos == 0 && !(data & (1<<3))) {
+        return true;
+    }
+    packet[packet_pos++] = data;
+    if (packet_pos < PS2_MOUSE_PACKET_SIZE) {
+        return true;
+    }
+    packet_pos = 0;
+
+    // 9-bit values, the overflow bits saturate them
+    uint8_t status = packet[0];
+    int16_t x = (status & (1<<PS2_MOUSE_X_SIGN)) ? (int16_t)packet[1] - 256 : packet[1];
+    int16_t y = (status & (1<<PS2_MOUSE_Y_SIGN)) ? (int16_t)packet[2] - 256 : packet[2];
+    if (status & (1<<PS2_MOUSE_X_OVFLW)) x = (status & (1<<PS2_MOUSE_X_SIGN)) ? -255 : 255;
+    if (status & (1<<PS2_MOUSE_Y_OVFLW)) y = (status & (1<<PS2_MOUSE_Y_SIGN)) ? -255 : 255;
+#ifdef PS2_MOUSE_ENABLE_SCROLLING
+    int8_t v = saturate((int8_t)(packet[3] & PS2_MOUSE_SCROLL_MASK), 127);
+#else
+    int8_t v = 0;
+#endif
+    uint8_t buttons = status & PS2_MOUSE_BTN_MASK;
+
+    // a full queue counts the packet in ps2_mouse_packet_dropped()
+    ps2_mouse_packet_t queued = { .buttons = buttons, .x = x, .y = y, .v = v };
+    ps2_mouse_packet_put(&queued);
+    return true;
+}
+
+static bool packet_dequeue(ps2_mouse_packet_t *packet) {
+    uint8_t sreg = SREG;
+    cli();
+    bool has_packet = ps2_mouse_packet_get(packet);
+    SREG = sreg;
+    return has_packet;
+}
+
+static int8_t take_report_units(int16_t *value) {
+    int16_t units = saturate(*value, 127);
+    *value -= units;
+    return units;
+}
+
+void ps2_mouse_task(void) {
+    static uint8_t buttons_prev = 0;
+    extern int tp_buttons;
+    ps2_mouse_packet_t packet;
+
+    while (packet_dequeue(&packet)) {
+        int16_t x = saturate((int32_t)packet.x * PS2_MOUSE_X_MULTIPLIER, INT16_MAX);
+        int16_t y = saturate((int32_t)packet.y * PS2_MOUSE_Y_MULTIPLIER, INT16_MAX);
+
+        if (!x && !y && !packet.v && !((packet.buttons ^ buttons_prev) & PS2_MOUSE_BTN_MASK)) {
+            continue;
+        }
+        buttons_prev = packet.buttons;
+
+        // split what does not fit in one report
+        do {
+            mouse_report.buttons = packet.buttons | tp_buttons;
+            mouse_report.x = take_report_units(&x);
+            mouse_report.y = take_report_units(&y);
+            mouse_report.v = -packet.v * PS2_MOUSE_V_MULTIPLIER;
+            packet.v = 0;
+#ifdef PS2_MOUSE_DEBUG_RAW
+            ps2_mouse_print_report(&mouse_report);
+#endif
+            ps2_mouse_orient_report(&mouse_report);
+            ps2_mouse_send_report(&mouse_report);
+            ps2_mouse_clear_report(&mouse_report);
+        } while (x || y);
+    }
+}
+#else
 void ps2_mouse_task(void) {
     static uint8_t buttons_prev = 0;
     extern int tp_buttons;
@@ -98,18 +217,24 @@ void ps2_mouse_task(void) {
 #endif
         buttons_prev = mouse_report.buttons;
         ps2_mouse_convert_report_to_hid(&mouse_report);
-#if PS2_MOUSE_SCROLL_BTN_MASK
-        ps2_mouse_scroll_button_task(&mouse_report);
-#endif
-#ifdef PS2_MOUSE_DEBUG_HID
-        // Used to debug the bytes sent to the host
-        ps2_mouse_print_report(&mouse_report);
-#endif
-        host_mouse_send(&mouse_report);
+        ps2_mouse_send_report(&mouse_report);
     }
 
     ps2_mouse_clear_report(&mouse_report);
 }
+#endif
+
+void ps2_mouse_stream_pause(void) {
+#ifdef PS2_MOUSE_USE_STREAM_INT
+    stream_paused++;
+#endif
+}
+
+void ps2_mouse_stream_resume(void) {
+#ifdef PS2_MOUSE_USE_STREAM_INT
+    if (stream_paused) stream_paused--;
+#endif
+}
 
 void ps2_mouse_disable_data_reporting(void) {
     PS2_MOUSE_SEND(PS2_MOUSE_DISABLE_DATA_REPORTING, "ps2 mouse disable data reporting");
@@ -169,6 +294,10 @@ static inline void ps2_mouse_convert_report_to_hid(report_mouse_t *mouse_report)
     // remove sign and overflow flags
     mouse_report->buttons &= PS2_MOUSE_BTN_MASK;
 
+    ps2_mouse_orient_report(mouse_report);
+}
+
+static inline void ps2_mouse_orient_report(report_mouse_t *mouse_report) {
 #ifdef PS2_MOUSE_INVERT_X
     mouse_report->x = -mouse_report->x;
 #endif
@@ -179,6 +308,25 @@ static inline void ps2_mouse_convert_report_to_hid(report_mouse_t *mouse_report)
 
 }
 
+static inline void ps2_mouse_send_report(report_mouse_t *mouse_report) {
+#if PS2_MOUSE_SCROLL_BTN_MASK
+    ps2_mouse_scroll_button_task(mouse_report);
+#endif
+#ifdef PS2_MOUSE_DEBUG_HID
+    // Used to debug the bytes sent to the host
+    ps2_mouse_print_report(mouse_report);
+#endif
+#ifdef POINTING_DEVICE_ENABLE
+    // coalesced with the other pointing devices by pointing_device_task()
+    pointing_device_add_motion(mouse_report->x, mouse_report->y,
+                               mouse_report->v * POINTING_DEVICE_WHEEL_RESOLUTION,
+                               mouse_report->h * POINTING_DEVICE_WHEEL_RESOLUTION);
+    pointing_device_set_buttons(mouse_report->buttons);
+#else
+    host_mouse_send(mouse_report);
+#endif
+}
+
 static inline void ps2_mouse_clear_report(report_mouse_t *mouse_report) {
     mouse_report->x = 0;
     mouse_report->y = 0;
@@ -21,9 +21,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdbool.h>
 #include "debug.h"
 
+/* In stream mode with the interrupt or USART driver the packets are put
+ * together by the receive interrupt, see ps2_mouse_stream_byte(). It
+ * starts once ps2_mouse_init_user() has returned and is paused while a
+ * command is sent so the responses reach ps2_host_recv. */
+#if !defined(PS2_MOUSE_USE_REMOTE_MODE) && (defined(PS2_USE_INT) || defined(PS2_USE_USART))
+#define PS2_MOUSE_USE_STREAM_INT
+#endif
+
 #define PS2_MOUSE_SEND(command, message) \
 do { \
+   ps2_mouse_stream_pause(); \
    __attribute__ ((unused)) uint8_t rcv = ps2_host_send(command); \
+   ps2_mouse_stream_resume(); \
    if (debug_mouse) { \
         print((message)); \
         xprintf(" command: %X, result: %X, error: %X \n", command, rcv, ps2_error); \
@@ -55,7 +65,9 @@ do { \
 
 #define PS2_MOUSE_RECEIVE(message) \
 do { \
+   ps2_mouse_stream_pause(); \
    __attribute__ ((unused)) uint8_t rcv = ps2_host_recv_response(); \
+   ps2_mouse_stream_resume(); \
    if (debug_mouse) { \
         print((message)); \
         xprintf(" result: %X, error: %X \n", rcv, ps2_error); \
@@ -114,6 +126,10 @@ static enum ps2_mouse_mode_e {
 #ifndef PS2_MOUSE_SCROLL_MASK       
 #define PS2_MOUSE_SCROLL_MASK           0xFF 
 #endif
+/* number of packets with different button states buffered between tasks */
+#ifndef PS2_MOUSE_PACKET_QUEUE_SIZE
+#define PS2_MOUSE_PACKET_QUEUE_SIZE     8
+#endif
 #ifndef PS2_MOUSE_INIT_DELAY
 #define PS2_MOUSE_INIT_DELAY            1000
 #endif
@@ -175,4 +191,16 @@ void ps2_mouse_set_resolution(ps2_mouse_resolution_t resolution);
 
 void ps2_mouse_set_sample_rate(ps2_mouse_sample_rate_t sample_rate);
 
+/* Wrap direct ps2_host_send() and ps2_host_recv_response() calls made
+ * after ps2_mouse_init() in these, otherwise the responses may be taken
+ * for motion packets. They nest and do nothing without PS2_MOUSE_USE_STREAM_INT. */
+void ps2_mouse_stream_pause(void);
+
+void ps2_mouse_stream_resume(void);
+
+#ifdef PS2_MOUSE_USE_STREAM_INT
+/* Called from the receive interrupt, returns false if the byte is not part of a packet */
+bool ps2_mouse_stream_byte(uint8_t data);
+#endif
+
 #endif
@@ -0,0 +1,60 @@
+/*
+Copyright 2026 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ps2_mouse_packet.h"
+
+static ps2_mouse_packet_t packet_queue[PS2_MOUSE_PACKET_QUEUE_SIZE];
+static uint8_t packet_head = 0;
+static uint8_t packet_tail = 0;
+static uint16_t packets_dropped = 0;
+
+static int16_t saturate(int32_t value, int16_t limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+bool ps2_mouse_packet_put(const ps2_mouse_packet_t *packet) {
+    uint8_t next = (packet_head + 1) % PS2_MOUSE_PACKET_QUEUE_SIZE;
+    if (packet_head != packet_tail) {
+        ps2_mouse_packet_t *newest = &packet_queue[(packet_head + PS2_MOUSE_PACKET_QUEUE_SIZE - 1) % PS2_MOUSE_PACKET_QUEUE_SIZE];
+        if (newest->buttons == packet->buttons) {
+            newest->x = saturate((int32_t)newest->x + packet->x, INT16_MAX);
+            newest->y = saturate((int32_t)newest->y + packet->y, INT16_MAX);
+            newest->v = saturate(newest->v + packet->v, 127);
+            return true;
+        }
+    }
+    if (next == packet_tail) {
+        if (packets_dropped != UINT16_MAX) packets_dropped++;
+        return false;
+    }
+    packet_queue[packet_head] = *packet;
+    packet_head = next;
+    return true;
+}
+
+bool ps2_mouse_packet_get(ps2_mouse_packet_t *packet) {
+    if (packet_head == packet_tail) {
+        return false;
+    }
+    *packet = packet_queue[packet_tail];
+    packet_tail = (packet_tail + 1) % PS2_MOUSE_PACKET_QUEUE_SIZE;
+    return true;
+}
+
+uint16_t ps2_mouse_packet_dropped(void) {
+    return packets_dropped;
+}
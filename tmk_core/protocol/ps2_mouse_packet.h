@@ -0,0 +1,53 @@
+/*
+Copyright 2026 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PS2_MOUSE_PACKET_H
+#define PS2_MOUSE_PACKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ps2_mouse.h"
+
+/* Stream mode packets, put together by the receive interrupt. The motion
+ * of packets arriving before the task gets to them is merged as long as
+ * the buttons don't change, so none of it is lost when the main loop is
+ * busy. Packets with different buttons are never merged: with the queue
+ * full such a packet is dropped and counted instead. The buttons are a
+ * state, not a change, so the next packet that fits puts them right. */
+typedef struct {
+    uint8_t buttons;
+    int16_t x;
+    int16_t y;
+    int8_t  v;
+} ps2_mouse_packet_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Called from the receive interrupt, returns false if the packet was dropped */
+bool ps2_mouse_packet_put(const ps2_mouse_packet_t *packet);
+/* The oldest packet, with interrupts disabled by the caller */
+bool ps2_mouse_packet_get(ps2_mouse_packet_t *packet);
+/* Packets dropped on a full queue since start up */
+uint16_t ps2_mouse_packet_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
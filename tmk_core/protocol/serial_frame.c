@@ -0,0 +1,106 @@
+/*
+Copyright 2026 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "timer.h"
+#include "serial_frame.h"
+
+
+/* Triple buffer: the interrupt fills frames[rx_index], the main loop
+ * copies from frames[read_index] and frames[shared_index] holds the
+ * latest complete frame until one of them swaps it out. */
+static uint8_t frames[3][SERIAL_FRAME_LENGTH];
+static uint8_t rx_index = 0;
+static uint8_t rx_pos = 0;
+static uint8_t read_index = 1;
+static volatile uint8_t shared_index = 2;
+static volatile bool frame_ready = false;
+
+#ifdef SERIAL_FRAME_REQUEST
+static volatile bool request_pending = false;
+static uint16_t request_time = 0;
+
+static void serial_frame_request(void)
+{
+    if (request_pending && timer_elapsed(request_time) < SERIAL_FRAME_TIMEOUT) {
+        return;
+    }
+    if (!SERIAL_UART_TXD_READY) {
+        return;
+    }
+    request_pending = true;
+    request_time = timer_read();
+    SERIAL_UART_DATA = SERIAL_FRAME_REQUEST;
+}
+#endif
+
+void serial_frame_init(void)
+{
+    SERIAL_UART_INIT();
+}
+
+bool serial_frame_read(uint8_t *frame)
+{
+#ifdef SERIAL_FRAME_REQUEST
+    serial_frame_request();
+#endif
+
+    if (!frame_ready) {
+        return false;
+    }
+
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t index = shared_index;
+    shared_index = read_index;
+    read_index = index;
+    frame_ready = false;
+    SREG = sreg;
+
+    memcpy(frame, frames[read_index], SERIAL_FRAME_LENGTH);
+    return true;
+}
+
+ISR(SERIAL_UART_RXD_VECT)
+{
+    uint8_t data = SERIAL_UART_DATA;
+
+    if (rx_pos < SERIAL_FRAME_LENGTH) {
+        if (data == SERIAL_FRAME_END) {
+            /* end of a short frame, start over */
+            rx_pos = 0;
+        } else {
+            frames[rx_index][rx_pos++] = data;
+        }
+        return;
+    }
+
+    rx_pos = 0;
+    if (data == SERIAL_FRAME_END) {
+        uint8_t index = shared_index;
+        shared_index = rx_index;
+        rx_index = index;
+        frame_ready = true;
+#ifdef SERIAL_FRAME_REQUEST
+        request_pending = false;
+#endif
+    }
+}
@@ -0,0 +1,55 @@
+/*
+Copyright 2026 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+/*--------------------------------------------------------------------
+ * Interrupt driven receiver for fixed size frames on the hardware UART
+ *
+ * For matrices reported by another microcontroller, such as the RF
+ * receivers of wireless split keyboards. The receive interrupt collects
+ * SERIAL_FRAME_LENGTH data bytes followed by the SERIAL_FRAME_END byte,
+ * which must never appear among the data bytes. Frames that end in
+ * anything else are dropped and the receiver syncs up on the next one.
+ *
+ * If SERIAL_FRAME_REQUEST is defined, that byte is sent to ask for a
+ * frame each time the previous one arrived, or after
+ * SERIAL_FRAME_TIMEOUT milliseconds without an answer.
+ *
+ * Uses the SERIAL_UART_* settings of serial_uart.c, and
+ * SERIAL_UART_INIT() must enable the receive interrupt.
+ *------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SERIAL_FRAME_LENGTH
+#   error "SERIAL_FRAME_LENGTH is required in config.h"
+#endif
+#ifndef SERIAL_FRAME_END
+#   error "SERIAL_FRAME_END is required in config.h"
+#endif
+#ifndef SERIAL_FRAME_TIMEOUT
+#   define SERIAL_FRAME_TIMEOUT 5
+#endif
+
+void serial_frame_init(void);
+/* Copy the latest complete frame, without its end byte, into frame.
+ * Returns false and leaves frame alone if no new frame has arrived
+ * since the last call. Never waits. */
+bool serial_frame_read(uint8_t *frame);
+
+#endif
@@ -1,51 +1,73 @@
 #ifndef RING_BUFFER_H
 #define RING_BUFFER_H
 /*--------------------------------------------------------------------
- * Ring buffer to store scan codes from keyboard
+ * Single producer, single consumer ring buffers
+ *
+ * RING_BUFFER(name, type, size) defines a buffer of `size` elements of
+ * `type`, where `size` is a power of two up to 256, and these functions:
+ *
+ *   bool    name_put(type value)   add an element, false if full
+ *   bool    name_get(type *value)  take the oldest element, false if empty
+ *   bool    name_has_data(void)
+ *   uint8_t name_space(void)       number of free elements
+ *   void    name_clear(void)       drop all the elements
+ *
+ * One side, typically an interrupt handler, may only put and the other
+ * side may only get, check and clear. Each index is a single byte
+ * written by one side only, so neither side needs to disable
+ * interrupts. One element is left unused to tell full from empty.
  *------------------------------------------------------------------*/
-#define RBUF_SIZE 32
-#include <util/atomic.h>
-static uint8_t rbuf[RBUF_SIZE];
-static uint8_t rbuf_head = 0;
-static uint8_t rbuf_tail = 0;
-static inline void rbuf_enqueue(uint8_t data)
-{
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    uint8_t next = (rbuf_head + 1) % RBUF_SIZE;
-    if (next != rbuf_tail) {
-        rbuf[rbuf_head] = data;
-        rbuf_head = next;
-    } else {
-        print("rbuf: full\n");
-    }
-  }
-}
-static inline uint8_t rbuf_dequeue(void)
-{
-    uint8_t val = 0;
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+#include <stdint.h>
+#include <stdbool.h>
 
-    if (rbuf_head != rbuf_tail) {
-        val = rbuf[rbuf_tail];
-        rbuf_tail = (rbuf_tail + 1) % RBUF_SIZE;
-    }
-  }
+/* keep the element accesses on the right side of the index updates */
+#define RING_BUFFER_BARRIER() __asm__ __volatile__ ("" ::: "memory")
 
-    return val;
-}
-static inline bool rbuf_has_data(void)
-{
-  bool has_data;
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    has_data = (rbuf_head != rbuf_tail);
-  }
-  return has_data;
-}
-static inline void rbuf_clear(void)
-{
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    rbuf_head = rbuf_tail = 0;
-  }
-}
+#define RING_BUFFER(name, type, size) \
+    typedef char name##_size_must_be_a_power_of_two[((size) & ((size) - 1)) == 0 && (size) <= 256 ? 1 : -1]; \
+    static type name##_buf[size]; \
+    static volatile uint8_t name##_head = 0; \
+    static volatile uint8_t name##_tail = 0; \
+    __attribute__ ((unused)) \
+    static inline bool name##_put(type value) \
+    { \
+        uint8_t head = name##_head; \
+        uint8_t next = (head + 1) & ((size) - 1); \
+        if (next == name##_tail) { \
+            return false; \
+        } \
+        name##_buf[head] = value; \
+        RING_BUFFER_BARRIER(); \
+        name##_head = next; \
+        return true; \
+    } \
+    __attribute__ ((unused)) \
+    static inline bool name##_get(type *value) \
+    { \
+        uint8_t tail = name##_tail; \
+        if (tail == name##_head) { \
+            return false; \
+        } \
+        RING_BUFFER_BARRIER(); \
+        *value = name##_buf[tail]; \
+        RING_BUFFER_BARRIER(); \
+        name##_tail = (tail + 1) & ((size) - 1); \
+        return true; \
+    } \
+    __attribute__ ((unused)) \
+    static inline bool name##_has_data(void) \
+    { \
+        return name##_head != name##_tail; \
+    } \
+    __attribute__ ((unused)) \
+    static inline uint8_t name##_space(void) \
+    { \
+        return (name##_tail - name##_head - 1) & ((size) - 1); \
+    } \
+    __attribute__ ((unused)) \
+    static inline void name##_clear(void) \
+    { \
+        name##_tail = name##_head; \
+    }
 
 #endif  /* RING_BUFFER_H */